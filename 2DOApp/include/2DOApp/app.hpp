@@ -1,14 +1,23 @@
 #pragma once
 
+#include <exception>
 #include <memory>
 #include <optional>
 
 #include <fmt/color.h>
 #include <fmt/core.h>
 
+#include <2DOCore/archive.hpp>
+#include <2DOCore/backup.hpp>
+#include <2DOCore/database.hpp>
+#include <2DOCore/pool.hpp>
+#include <2DOCore/scheduler.hpp>
 #include <2DOCore/task.hpp>
 #include <2DOCore/term.hpp>
+#include <2DOCore/transfer.hpp>
 #include <2DOCore/user.hpp>
+#include <2DOCore/wipe.hpp>
+#include <2DOCore/write_queue.hpp>
 #include <Utils/result.hpp>
 #include <Utils/type.hpp>
 #include <Utils/util.hpp>
@@ -28,10 +37,28 @@ namespace tdu = twodoutils;
 #define DB_NAME "2do_db.db3"
 #define ERR_LOGS_FILE_NAME "big_error_logs.txt"
 #define USER_LOGS_FILE_NAME "user_logs.txt"
+#define DB_PROFILE_ENV "TDO_DB_PROFILE"
+#define NEXT_PAGE_OPTION ">"
+#define TASKS_PAGE_SIZE 20
+#define CHAT_HISTORY_SIZE 50
+#define SEARCH_RESULTS_LIMIT 20
+#define DASHBOARD_DUE_DAYS 7
+#define REMINDER_LEAD_MINUTES 60
+#define SNAPSHOTS_FOLDER_NAME "snapshots"
+#define SNAPSHOT_INTERVAL_MINUTES 60
+#define SNAPSHOT_RETENTION 7
+#define ARCHIVE_NAME "2do_archive.db3"
+#define ARCHIVE_AFTER_DAYS 30
 
 namespace twodo {
 struct Updated {};
+struct NextPage {};
+
+// One row of a task list, formatted into a single allocation.
+[[nodiscard]] String format_task_line(const unsigned int number,
+                                      const tdc::TaskSummary& summary);
 struct Wiped {};
+struct Restored {};
 
 class [[nodiscard]] App {
   public:
@@ -60,17 +87,35 @@ class [[nodiscard]] App {
 
     void run();
 
+    // Runs "export|import <table> <file.csv|file.jsonl>" without the menu.
+    // Returns the process exit code.
+    int run_command(const Vector<StringView>& args);
+
   private:
     inline static std::shared_ptr<App> instance = nullptr;
 
     std::optional<tdc::User> m_current_user{};
+    std::shared_ptr<tdc::ConnectionPool> m_pool = nullptr;
+    // The writer, for the write queue and for the maintenance jobs that must
+    // hold it: wipe, restore, import and the archive move.
+    std::shared_ptr<tdc::Connection> m_connection = nullptr;
+    // The UI thread's reader, which the repositories below read through.
+    std::optional<tdc::ReaderLease> m_reader{};
     std::shared_ptr<tdc::UserDb> m_user_db = nullptr;
     std::optional<tdc::TaskDb> m_task_db{};
-    std::optional<tdc::MessageDb> m_message_db{};
     std::optional<tdc::AuthenticationManager> m_auth_manager{};
+    // Over the writer, used only by the writes queued on m_writes.
+    std::shared_ptr<tdc::UserDb> m_user_writer = nullptr;
+    std::optional<tdc::TaskDb> m_task_writer{};
+    std::optional<tdc::MessageDb> m_message_writer{};
+    std::shared_ptr<tdc::SnapshotStore> m_snapshots = nullptr;
+    std::shared_ptr<tdc::TaskArchive> m_archive = nullptr;
 
     std::shared_ptr<tdu::IPrinter> m_printer = nullptr;
     std::shared_ptr<tdu::IUserInputHandler> m_input_handler = nullptr;
+    // Last, so writes still queued when the app goes away are drained while
+    // everything they use is alive.
+    std::shared_ptr<tdc::WriteQueue> m_writes = nullptr;
 
     enum class UserUpdateEvent {
         UsernameUpdate,
@@ -90,41 +135,53 @@ class [[nodiscard]] App {
     tdc::Menu load_menu();
     std::shared_ptr<tdc::Page> load_tasks_menu() const;
     std::shared_ptr<tdc::Page> load_create_tasks_menu() const;
+    std::shared_ptr<tdc::Page> load_search_tasks_menu() const;
+    std::shared_ptr<tdc::Page> load_archived_tasks_menu() const;
+    std::shared_ptr<tdc::Page> load_dashboard_menu() const;
     std::shared_ptr<tdc::Page> load_settings_menu();
     std::shared_ptr<tdc::Page> load_user_manager_menu();
     std::shared_ptr<tdc::Page> load_user_update_menu();
     std::shared_ptr<tdc::Page> load_new_user_menu() const;
     std::shared_ptr<tdc::Page> load_advanced_menu() const;
+    std::shared_ptr<tdc::Page> load_backups_menu() const;
+    std::shared_ptr<tdc::Page> load_archive_menu() const;
 
     template <tdc::TaskDb::IdType T>
     void load_update_tasks_menu() const {
-        Vector<tdc::Task> tasks;
-        if constexpr (T == tdc::TaskDb::IdType::Executor) {
-            tasks = m_task_db->get_all_objects<tdc::TaskDb::IdType::Executor>(
-                m_current_user->id());
-        } else {
-            tasks = m_task_db->get_all_objects<tdc::TaskDb::IdType::Owner>(
-                m_current_user->id());
+        unsigned int after_id = 0;
+        while (load_update_tasks_page<T>(after_id)) {
+        }
+    }
+
+    // Shows one screen of tasks following after_id. Returns true when the
+    // user asked for the next page, with after_id moved past this one.
+    template <tdc::TaskDb::IdType T>
+    bool load_update_tasks_page(unsigned int& after_id) const {
+        Vector<tdc::TaskSummary> summaries;
+        summaries.reserve(TASKS_PAGE_SIZE);
+        for (auto&& summary : m_task_db->stream_all_summaries<T>(
+                 m_current_user->id(), after_id, TASKS_PAGE_SIZE)) {
+            summaries.push_back(std::move(summary));
         }
+        // Full tasks are read only when opened.
+        Vector<std::optional<tdc::Task>> tasks(summaries.size());
 
         const auto tasks_page = std::make_shared<tdc::Page>("Tasks", [&] {
             unsigned int count = 0;
-            for (const auto& task : tasks) {
-                m_printer->msg_print(fmt::format(
-                    "[{}] {} ({})\n",
-                    fmt::format(fg(fmt::color::blue_violet),
-                                std::to_string(++count)),
-                    fmt::format(fg(fmt::color::blue_violet), task.topic()),
-                    (task.is_done()
-                         ? fmt::format(fmt::fg(fmt::color::green), "DONE")
-                         : fmt::format(fmt::fg(fmt::color::red),
-                                       "INCOMPLETE"))));
+            for (const auto& summary : summaries) {
+                m_printer->msg_print(format_task_line(++count, summary));
             }
         });
 
-        unsigned int count = 0;
-        for (auto& task : tasks) {
+        for (std::size_t i = 0; i < summaries.size(); ++i) {
+            const auto& summary = summaries[i];
+            auto& slot = tasks[i];
+
             const auto chosen_task = std::make_shared<tdc::Page>([&] {
+                const tdc::Task& task = open_task(slot, summary.id());
+                tdu::TimePointChars start_date;
+                tdu::TimePointChars deadline;
+
                 if constexpr (T == tdc::TaskDb::IdType::Executor) {
                     m_printer->msg_print(fmt::format(
                         "Topic: {}\nContent: {}\nDelegated By: {}\nStart "
@@ -133,8 +190,10 @@ class [[nodiscard]] App {
                         "{}\nStatus: {}\n\n",
                         task.topic(), task.content(),
                         m_user_db->get_object(task.owner_id()).username(),
-                        tdu::to_string(task.start_date<TimePoint>()),
-                        tdu::to_string(task.deadline<TimePoint>()),
+                        tdu::format_time_point(task.start_date<TimePoint>(),
+                                               start_date),
+                        tdu::format_time_point(task.deadline<TimePoint>(),
+                                               deadline),
                         (task.is_done()
                              ? fmt::format(fmt::fg(fmt::color::green), "DONE")
                              : fmt::format(fmt::fg(fmt::color::red),
@@ -147,8 +206,10 @@ class [[nodiscard]] App {
                         "{}\nStatus: {}\n\n",
                         task.topic(), task.content(),
                         m_user_db->get_object(task.executor_id()).username(),
-                        tdu::to_string(task.start_date<TimePoint>()),
-                        tdu::to_string(task.deadline<TimePoint>()),
+                        tdu::format_time_point(task.start_date<TimePoint>(),
+                                               start_date),
+                        tdu::format_time_point(task.deadline<TimePoint>(),
+                                               deadline),
                         (task.is_done()
                              ? fmt::format(fmt::fg(fmt::color::green), "DONE")
                              : fmt::format(fmt::fg(fmt::color::red),
@@ -158,15 +219,16 @@ class [[nodiscard]] App {
 
             const auto change_status =
                 std::make_shared<tdc::Page>("Mark As Complete", false, [&] {
-                    if (task_completion_event(task)) {
+                    if (task_completion_event(open_task(slot, summary.id()))) {
                         throw Updated{};
                     }
                 });
 
             const auto discussion = std::make_shared<tdc::Page>(
-                "Discussion", false, [&] { discussion_event(task); });
+                "Discussion", false,
+                [&] { discussion_event(open_task(slot, summary.id())); });
 
-            if (is_task_accessible(task)) {
+            if (is_task_accessible(summary)) {
                 chosen_task->attach(FIRST_OPTION, change_status);
                 chosen_task->attach(SECOND_OPTION, discussion);
             }
@@ -177,7 +239,7 @@ class [[nodiscard]] App {
                 const auto edit_topic =
                     std::make_shared<tdc::Page>("Edit Topic", false, [&] {
                         if (task_update_event(TaskUpdateEvent::TopicUpdate,
-                                              task)) {
+                                              open_task(slot, summary.id()))) {
                             throw Updated{};
                         }
                     });
@@ -185,7 +247,7 @@ class [[nodiscard]] App {
                 const auto edit_content =
                     std::make_shared<tdc::Page>("Edit Content", false, [&] {
                         if (task_update_event(TaskUpdateEvent::ContentUpdate,
-                                              task)) {
+                                              open_task(slot, summary.id()))) {
                             throw Updated{};
                         }
                     });
@@ -193,7 +255,7 @@ class [[nodiscard]] App {
                 const auto change_deadline =
                     std::make_shared<tdc::Page>("Change Deadline", false, [&] {
                         if (task_update_event(TaskUpdateEvent::DeadlineUpdate,
-                                              task)) {
+                                              open_task(slot, summary.id()))) {
                             throw Updated{};
                         }
                     });
@@ -201,7 +263,7 @@ class [[nodiscard]] App {
                 const auto change_executor =
                     std::make_shared<tdc::Page>("Change Executor", false, [&] {
                         if (task_update_event(TaskUpdateEvent::ExecutorUpdate,
-                                              task)) {
+                                              open_task(slot, summary.id()))) {
                             throw Updated{};
                         }
                     });
@@ -209,12 +271,12 @@ class [[nodiscard]] App {
                 const auto delete_task =
                     std::make_shared<tdc::Page>("Delete Task", false, [&] {
                         if (task_update_event(TaskUpdateEvent::TaskDelete,
-                                              task)) {
+                                              open_task(slot, summary.id()))) {
                             throw Updated{};
                         }
                     });
 
-                if (is_task_accessible(task)) {
+                if (is_task_accessible(summary)) {
                     chosen_task->attach(THIRD_OPTION, edit_task);
                 }
 
@@ -225,24 +287,45 @@ class [[nodiscard]] App {
                 edit_task->attach(FIFTH_OPTION, delete_task);
             }
 
-            tasks_page->attach(std::to_string(++count), chosen_task);
+            tasks_page->attach(std::to_string(i + 1), chosen_task);
+        }
+
+        if (summaries.size() == TASKS_PAGE_SIZE) {
+            const auto next_page = std::make_shared<tdc::Page>(
+                "Next Page", false, [] { throw NextPage{}; });
+            tasks_page->attach(NEXT_PAGE_OPTION, next_page);
         }
 
         try {  // ugliness
             tdc::Menu{tasks_page, m_printer, m_input_handler}.run(QUIT_OPTION);
         } catch (const Updated) {
+        } catch (const NextPage) {
+            after_id = summaries.back().id();
+            return true;
         }
+
+        return false;
     }
 
     bool sing_in();
     void sing_up() const;
     bool is_first_user() const;
     bool is_task_accessible(const tdc::Task& task) const;
+    bool is_task_accessible(const tdc::TaskSummary& summary) const;
+    // Open tasks before their deadline, and any task the user owns.
+    bool is_task_accessible(const unsigned int owner_id,
+                            const TimePoint deadline,
+                            const bool is_done) const;
+    tdc::Task& open_task(std::optional<tdc::Task>& slot,
+                         const unsigned int id) const;
     bool user_update_event(const UserUpdateEvent kind, tdc::User& user);
     void update_current_user(const tdc::User& user);
     bool task_update_event(const TaskUpdateEvent kind, tdc::Task& task) const;
     bool task_completion_event(tdc::Task& task) const;
     void discussion_event(const tdc::Task& task) const;
+    void write_error_event(std::exception_ptr error) const;
+    void reminder_event(const unsigned int user_id,
+                        const tdc::Reminder& reminder) const;
     String username_validation_event() const;
     String password_validation_event() const;
     tdc::Role role_choosing_event() const;
@@ -2,6 +2,7 @@
 #include <conio.h>
 #endif
 
+#include <cstdlib>
 #include <filesystem>
 #include <iostream>
 #include <memory>
@@ -88,15 +89,21 @@ class MsgDisplayer : public tdu::IPrinter {
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
+    const Vector<StringView> args(argv + 1, argv + argc);
+
     try {
-        td::App::getInstance()
-            ->set_dependencies(std::make_shared<MsgDisplayer>(),
-                               std::make_shared<UserInput>())
-            ->run();
+        const auto app = td::App::getInstance()->set_dependencies(
+            std::make_shared<MsgDisplayer>(), std::make_shared<UserInput>());
+
+        if (!args.empty()) {
+            return app->run_command(args);
+        }
+        app->run();
     } catch (const std::runtime_error& e) {
         tdu::log_to_file(e.what(), fs::current_path().root_path() /
                                        ENV_FOLDER_NAME / ERR_LOGS_FILE_NAME);
         fmt::print(stderr, "Error: {}", std::move(e.what()));
+        return EXIT_FAILURE;
     }
 }
\ No newline at end of file
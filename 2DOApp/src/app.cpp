@@ -1,7 +1,12 @@
 #include "2DOApp/app.hpp"
 
+#include <charconv>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <memory>
+#include <stop_token>
 #include <thread>
 
 #include "Utils/util.hpp"
@@ -10,14 +15,50 @@
 #include <fmt/core.h>
 
 namespace twodo {
+String format_task_line(const unsigned int number,
+                        const tdc::TaskSummary& summary) {
+    const bool done = summary.is_done();
+
+    return fmt::format(
+        "[{}] {} ({})\n", fmt::styled(number, fg(fmt::color::blue_violet)),
+        fmt::styled(summary.topic(), fg(fmt::color::blue_violet)),
+        fmt::styled(done ? "DONE" : "INCOMPLETE",
+                    fg(done ? fmt::color::green : fmt::color::red)));
+}
+
 App::App() {
     const auto base_path = tdu::create_app_env(
-        ENV_FOLDER_NAME, {DB_NAME, ERR_LOGS_FILE_NAME, USER_LOGS_FILE_NAME});
+        ENV_FOLDER_NAME,
+        {DB_NAME, ARCHIVE_NAME, ERR_LOGS_FILE_NAME, USER_LOGS_FILE_NAME});
+
+    const char* profile_name = std::getenv(DB_PROFILE_ENV);
+    const auto profile = tdc::find_connection_profile(
+        profile_name ? profile_name : tdc::BALANCED_PROFILE.name);
+    if (!profile) {
+        throw std::runtime_error("Unknown database profile.");
+    }
 
-    m_user_db = std::make_shared<tdc::UserDb>(base_path / DB_NAME);
-    m_task_db = tdc::TaskDb{base_path / DB_NAME};
-    m_message_db = tdc::MessageDb{base_path / DB_NAME};
+    m_pool = std::make_shared<tdc::ConnectionPool>(base_path / DB_NAME,
+                                                   profile.value());
+    m_connection = m_pool->writer();
+    m_reader.emplace(m_pool->acquire_reader());
+    m_user_db = std::make_shared<tdc::UserDb>(m_reader->connection());
+    m_task_db = tdc::TaskDb{m_reader->connection()};
     m_auth_manager = tdc::AuthenticationManager{m_user_db};
+    m_user_writer = std::make_shared<tdc::UserDb>(m_connection);
+    m_task_writer = tdc::TaskDb{m_connection};
+    m_message_writer = tdc::MessageDb{m_connection};
+    m_archive = std::make_shared<tdc::TaskArchive>(
+        m_connection, base_path / ARCHIVE_NAME,
+        sch::days{ARCHIVE_AFTER_DAYS}, m_reader->connection());
+    m_writes = std::make_shared<tdc::WriteQueue>(
+        m_connection,
+        [this](std::exception_ptr error) { write_error_event(error); });
+
+    const auto snapshots_path = base_path / SNAPSHOTS_FOLDER_NAME;
+    fs::create_directories(snapshots_path);
+    m_snapshots = std::make_shared<tdc::SnapshotStore>(
+        m_pool, snapshots_path, SNAPSHOT_RETENTION);
 };
 
 void App::run() {
@@ -25,21 +66,75 @@ void App::run() {
         sing_up();
     }
 
+    m_snapshots->start(sch::minutes{SNAPSHOT_INTERVAL_MINUTES});
+
     while (sing_in()) {
+        const auto archived =
+            m_archive->archive_done(tdu::get_current_timestamp());
+        if (archived.tasks > 0) {
+            m_printer->msg_print(fmt::format(
+                "Archived {} done tasks and {} messages older than {} days.",
+                archived.tasks, archived.messages,
+                m_archive->archive_after().count()));
+            tdu::sleep(2000);
+        }
+
+        const auto reader = m_pool->acquire_reader();
+        tdc::DeadlineScheduler reminders{
+            reader.connection(), sch::minutes{REMINDER_LEAD_MINUTES}};
+        reminders.start([this, user_id = m_current_user->id()](
+                            const tdc::Reminder& reminder) {
+            reminder_event(user_id, reminder);
+        });
+
         try {
             load_menu().run(QUIT_OPTION);
         } catch (const Wiped&) {
             sing_up();
+        } catch (const Restored&) {
+            if (is_first_user()) {
+                sing_up();
+            }
         }
     }
 }
 
+int App::run_command(const Vector<StringView>& args) {
+    const bool is_export = !args.empty() && args[0] == "export";
+    const bool is_import = !args.empty() && args[0] == "import";
+    const auto format = (args.size() == 3)
+                            ? tdc::transfer_format_of(fs::path{args[2]})
+                            : std::nullopt;
+
+    if (!(is_export || is_import) || !format) {
+        m_printer->err_print(
+            "Usage: 2do export|import <users|tasks|messages> "
+            "<file.csv|file.jsonl>\n");
+        return EXIT_FAILURE;
+    }
+
+    const fs::path path{args[2]};
+    const auto stats =
+        is_export
+            ? tdc::export_table(*m_reader->connection(), args[1], *format, path)
+            : tdc::import_table(*m_connection, args[1], *format, path);
+
+    m_printer->msg_print(fmt::format(
+        "{} {} rows in {:.2f} s ({:.0f} rows/s)\n",
+        is_export ? "Exported" : "Imported", stats.rows,
+        sch::duration<double>(stats.elapsed).count(),
+        stats.rows_per_second()));
+
+    return EXIT_SUCCESS;
+}
+
 tdc::Menu App::load_menu() {
     const auto main = std::make_shared<tdc::Page>(
         fmt::format("2DO [{}]", m_current_user->username()));
 
     main->attach(FIRST_OPTION, load_tasks_menu());
     main->attach(SECOND_OPTION, load_settings_menu());
+    main->attach(THIRD_OPTION, load_dashboard_menu());
 
     return tdc::Menu{main, m_printer, m_input_handler};
 }
@@ -58,6 +153,8 @@ std::shared_ptr<tdc::Page> App::load_tasks_menu() const {
                   }));
 
     tasks->attach(THIRD_OPTION, load_create_tasks_menu());
+    tasks->attach(FOURTH_OPTION, load_search_tasks_menu());
+    tasks->attach(FIFTH_OPTION, load_archived_tasks_menu());
 
     return std::move(tasks);
 }
@@ -87,11 +184,148 @@ std::shared_ptr<tdc::Page> App::load_create_tasks_menu() const {
                              false};
         };
 
-        m_task_db->add_object(task_input());
+        m_writes->submit(
+            [this, task = task_input()] { m_task_writer->add_object(task); });
         m_printer->msg_print("Task has been added successfully!");
     });
 }
 
+std::shared_ptr<tdc::Page> App::load_search_tasks_menu() const {
+    return std::make_shared<tdc::Page>("Search", false, [&] {
+        tdu::clear_term();
+        const auto query = string_input("Search: ");
+
+        // Only tasks the user owns or executes are listed.
+        const auto hits = m_task_db->search(query, m_current_user->id(),
+                                            SEARCH_RESULTS_LIMIT);
+
+        const auto results = std::make_shared<tdc::Page>("Results", [&] {
+            if (hits.empty()) {
+                m_printer->msg_print("No matching tasks.\n\n");
+            }
+
+            unsigned int count = 0;
+            for (const auto& hit : hits) {
+                m_printer->msg_print(fmt::format("{}. {}\n   {}\n", ++count,
+                                                 hit.topic, hit.snippet));
+            }
+        });
+
+        tdc::Menu{results, m_printer, m_input_handler}.run(QUIT_OPTION);
+    });
+}
+
+std::shared_ptr<tdc::Page> App::load_archived_tasks_menu() const {
+    return std::make_shared<tdc::Page>("Archived Tasks", false, [&] {
+        unsigned int after_id = 0;
+        bool next_page = true;
+
+        while (next_page) {
+            next_page = false;
+
+            // Read from the archive file only now, one page at a time.
+            Vector<tdc::Task> tasks;
+            tasks.reserve(TASKS_PAGE_SIZE);
+            for (auto&& task : m_archive->stream_tasks(
+                     m_current_user->id(), after_id, TASKS_PAGE_SIZE)) {
+                tasks.push_back(std::move(task));
+            }
+
+            const auto archived_page =
+                std::make_shared<tdc::Page>("Archived Tasks", [&] {
+                    if (tasks.empty()) {
+                        m_printer->msg_print("No archived tasks.\n\n");
+                    }
+
+                    unsigned int count = 0;
+                    for (const auto& task : tasks) {
+                        m_printer->msg_print(format_task_line(
+                            ++count, tdc::TaskSummary{
+                                         task.id(), String{task.topic()},
+                                         task.deadline<TimePoint>(),
+                                         task.owner_id(), task.is_done()}));
+                    }
+                });
+
+            for (std::size_t i = 0; i < tasks.size(); ++i) {
+                const auto& task = tasks[i];
+
+                const auto chosen_task = std::make_shared<tdc::Page>([&] {
+                    tdu::TimePointChars start_date;
+                    tdu::TimePointChars deadline;
+                    tdu::TimePointChars timestamp;
+
+                    m_printer->msg_print(fmt::format(
+                        "Topic: {}\nContent: {}\nStart Date: {}\n"
+                        "Deadline: {}\n\n",
+                        task.topic(), task.content(),
+                        tdu::format_time_point(task.start_date<TimePoint>(),
+                                               start_date),
+                        tdu::format_time_point(task.deadline<TimePoint>(),
+                                               deadline)));
+
+                    for (const auto& message :
+                         m_archive->get_messages(task.id())) {
+                        m_printer->msg_print(fmt::format(
+                            "[{}] <{}>: {}\n",
+                            tdu::format_time_point(
+                                message.timestamp<TimePoint>(), timestamp),
+                            message.sender_name(), message.content()));
+                    }
+                    m_printer->msg_print("\n");
+                });
+
+                archived_page->attach(std::to_string(i + 1), chosen_task);
+            }
+
+            if (tasks.size() == TASKS_PAGE_SIZE) {
+                archived_page->attach(
+                    NEXT_PAGE_OPTION,
+                    std::make_shared<tdc::Page>("Next Page", false,
+                                                [] { throw NextPage{}; }));
+            }
+
+            try {
+                tdc::Menu{archived_page, m_printer, m_input_handler}.run(
+                    QUIT_OPTION);
+            } catch (const NextPage) {
+                after_id = tasks.back().id();
+                next_page = true;
+            }
+        }
+    });
+}
+
+std::shared_ptr<tdc::Page> App::load_dashboard_menu() const {
+    return std::make_shared<tdc::Page>("Dashboard", false, [&] {
+        if (!privileges_validation_event()) {
+            return;
+        }
+
+        const auto dashboard = std::make_shared<tdc::Page>("Dashboard", [&] {
+            const auto stats = m_task_db->workload_stats(
+                tdu::get_current_timestamp(), sch::days{DASHBOARD_DUE_DAYS});
+
+            m_printer->msg_print(fmt::format(
+                "{:<20} {:>6} {:>6} {:>8} {:>8}\n", "User", "Open", "Done",
+                "Overdue",
+                fmt::format("Due {}d", DASHBOARD_DUE_DAYS)));
+            for (const auto& user : stats) {
+                m_printer->msg_print(fmt::format(
+                    "{:<20} {:>6} {:>6} {:>8} {:>8}\n", user.username,
+                    user.open, user.done,
+                    fmt::styled(user.overdue,
+                                fg(user.overdue ? fmt::color::red
+                                                : fmt::color::green)),
+                    user.due_soon));
+            }
+            m_printer->msg_print("\n");
+        });
+
+        tdc::Menu{dashboard, m_printer, m_input_handler}.run(QUIT_OPTION);
+    });
+}
+
 std::shared_ptr<tdc::Page> App::load_settings_menu() {
     const auto settings = std::make_shared<tdc::Page>("Settings");
 
@@ -188,7 +422,10 @@ std::shared_ptr<tdc::Page> App::load_new_user_menu() const {
             }
             const tdc::Role role = role_choosing_event();
 
-            m_user_db->add_object(tdc::User{username, role, password});
+            tdc::User user{username, role, password};
+            m_writes->submit([this, user = std::move(user)] {
+                m_user_writer->add_object(user);
+            });
 
             m_printer->msg_print("User has been added successfully!");
         }
@@ -207,10 +444,21 @@ std::shared_ptr<tdc::Page> App::load_advanced_menu() const {
 
             if (const auto choice = m_input_handler->get_input();
                 choice == YES) {
-                tdc::clear_all_db_data(
-                    fs::current_path().root_path() / "2DO" / DB_NAME,
-                    {"users", "tasks", "messages"});
-                m_printer->msg_print("Data wiped!");
+                m_writes->flush().wait();
+                const auto stats = tdc::clear_all_db_data(
+                    *m_connection, {"users", "tasks", "messages"},
+                    [&](const tdc::WipeProgress& progress) {
+                        m_printer->msg_print(
+                            fmt::format("[{}/{}] {}\n", progress.done,
+                                        progress.total, progress.step));
+                    });
+                m_archive->clear();
+                m_printer->msg_print(fmt::format(
+                    "Data wiped in {:.2f} s, {:.1f} MiB freed!",
+                    sch::duration<double>(stats.elapsed).count(),
+                    static_cast<double>(stats.bytes_before -
+                                        stats.bytes_after) /
+                        (1024 * 1024)));
                 tdu::sleep(2000);
 
                 throw Wiped{};
@@ -221,17 +469,161 @@ std::shared_ptr<tdc::Page> App::load_advanced_menu() const {
             }
         });
 
+    const auto cache_statistics =
+        std::make_shared<tdc::Page>("Cache Statistics", [&] {
+            const auto users = m_user_db->cache_stats();
+            const auto tasks = m_task_db->cache_stats();
+
+            m_printer->msg_print(fmt::format(
+                "Users: {} hits, {} misses\nTasks: {} hits, {} misses\n\n",
+                users.hits, users.misses, tasks.hits, tasks.misses));
+        });
+
     advanced->attach(FIRST_OPTION, wipe_all_data);
+    advanced->attach(SECOND_OPTION, cache_statistics);
+    advanced->attach(THIRD_OPTION, load_backups_menu());
+    advanced->attach(FOURTH_OPTION, load_archive_menu());
 
     return std::move(advanced);
 }
 
+std::shared_ptr<tdc::Page> App::load_backups_menu() const {
+    const auto backups = std::make_shared<tdc::Page>("Backups", [&] {
+        const auto snapshots = m_snapshots->list();
+
+        m_printer->msg_print(fmt::format(
+            "Snapshots: {} (keeping up to {})\nNewest: {}\n\n",
+            snapshots.size(), m_snapshots->keep(),
+            snapshots.empty() ? "none" : snapshots.front().name));
+    });
+
+    const auto take_snapshot =
+        std::make_shared<tdc::Page>("Take Snapshot Now", false, [&] {
+            m_snapshots->request();
+
+            m_printer->msg_print(
+                "The snapshot is being written in the background.");
+            tdu::sleep(2000);
+        });
+
+    const auto restore_snapshot =
+        std::make_shared<tdc::Page>("Restore Snapshot", false, [&] {
+            if (!privileges_validation_event())
+                return;
+
+            const auto root_page = std::make_shared<tdc::Page>("Snapshots");
+            const auto snapshots = m_snapshots->list();
+
+            unsigned int count = 0;
+            for (const auto& snapshot : snapshots) {
+                const auto chosen_snapshot = std::make_shared<tdc::Page>(
+                    snapshot.name, false, [&] {
+                        m_printer->msg_print(
+                            "Changes made since will be lost. Are you sure? "
+                            "[y/n]\n-> ");
+
+                        if (const auto choice = m_input_handler->get_input();
+                            choice == YES) {
+                            m_writes->flush().wait();
+                            m_snapshots->restore(snapshot);
+                            m_archive->reserve_archived_ids();
+                            m_printer->msg_print("Snapshot restored!");
+                            tdu::sleep(2000);
+
+                            throw Restored{};
+                        } else if (choice != NO) {
+                            invalid_option_event();
+                        }
+                    });
+
+                root_page->attach(std::to_string(++count), chosen_snapshot);
+            }
+
+            tdc::Menu{root_page, m_printer, m_input_handler}.run(QUIT_OPTION);
+        });
+
+    const auto set_retention =
+        std::make_shared<tdc::Page>("Set Retention", false, [&] {
+            if (!privileges_validation_event())
+                return;
+
+            const String input =
+                string_input("Number of snapshots to keep: ");
+
+            const char* input_end = input.data() + input.size();
+            std::size_t keep = 0;
+            const auto [end, error] =
+                std::from_chars(input.data(), input_end, keep);
+            if (error != std::errc{} || end != input_end || keep == 0) {
+                invalid_option_event();
+                return;
+            }
+
+            m_snapshots->set_keep(keep);
+        });
+
+    backups->attach(FIRST_OPTION, take_snapshot);
+    backups->attach(SECOND_OPTION, restore_snapshot);
+    backups->attach(THIRD_OPTION, set_retention);
+
+    return backups;
+}
+
+std::shared_ptr<tdc::Page> App::load_archive_menu() const {
+    const auto archive = std::make_shared<tdc::Page>("Archive", [&] {
+        m_printer->msg_print(fmt::format(
+            "Archived tasks: {}\nDone tasks are archived after {} days.\n\n",
+            m_archive->task_count(), m_archive->archive_after().count()));
+    });
+
+    const auto archive_now =
+        std::make_shared<tdc::Page>("Archive Done Tasks Now", false, [&] {
+            if (!privileges_validation_event())
+                return;
+
+            const auto stats =
+                m_archive->archive_done(tdu::get_current_timestamp());
+
+            m_printer->msg_print(fmt::format(
+                "Archived {} tasks and {} messages in {:.2f} s.",
+                stats.tasks, stats.messages,
+                sch::duration<double>(stats.elapsed).count()));
+            tdu::sleep(2000);
+        });
+
+    const auto set_age =
+        std::make_shared<tdc::Page>("Set Archive Age", false, [&] {
+            if (!privileges_validation_event())
+                return;
+
+            const String input =
+                string_input("Days a task stays done before archiving: ");
+
+            const char* input_end = input.data() + input.size();
+            int days = 0;
+            const auto [end, error] =
+                std::from_chars(input.data(), input_end, days);
+            if (error != std::errc{} || end != input_end || days < 0) {
+                invalid_option_event();
+                return;
+            }
+
+            m_archive->set_archive_after(sch::days{days});
+        });
+
+    archive->attach(FIRST_OPTION, archive_now);
+    archive->attach(SECOND_OPTION, set_age);
+
+    return archive;
+}
+
 bool App::user_update_event(UserUpdateEvent kind, tdc::User& user) {
     tdu::clear_term();
     switch (kind) {
         case UserUpdateEvent::UsernameUpdate: {
             user.set_username(username_validation_event());
-            m_user_db->update_object(user);
+            m_writes->submit(
+                [this, user] { m_user_writer->update_object(user); });
             update_current_user(user);
 
             m_printer->msg_print("Db updated successfully!");
@@ -241,7 +633,8 @@ bool App::user_update_event(UserUpdateEvent kind, tdc::User& user) {
 
         case UserUpdateEvent::PasswordUpdate: {
             user.set_password(password_validation_event());
-            m_user_db->update_object(user);
+            m_writes->submit(
+                [this, user] { m_user_writer->update_object(user); });
             update_current_user(user);
 
             m_printer->msg_print("Db updated successfully!");
@@ -256,7 +649,8 @@ bool App::user_update_event(UserUpdateEvent kind, tdc::User& user) {
 
             const tdc::Role role = role_choosing_event();
             user.set_role(role);
-            m_user_db->update_object(user);
+            m_writes->submit(
+                [this, user] { m_user_writer->update_object(user); });
             update_current_user(user);
 
             m_printer->msg_print("Db updated successfully!");
@@ -276,7 +670,9 @@ bool App::user_update_event(UserUpdateEvent kind, tdc::User& user) {
                     return false;
                 }
 
-                m_user_db->delete_object(user.id());
+                m_writes->submit([this, id = user.id()] {
+                    m_user_writer->delete_object(id);
+                });
 
                 m_printer->msg_print("Db updated successfully!");
                 tdu::sleep(2000);
@@ -306,7 +702,8 @@ bool App::task_update_event(const TaskUpdateEvent kind, tdc::Task& task) const {
 
             task.set_topic(string_input("Topic: "));
 
-            m_task_db->update_object(task);
+            m_writes->submit(
+                [this, task] { m_task_writer->update_object(task); });
 
             m_printer->msg_print("Db updated successfully!");
             tdu::sleep(2000);
@@ -317,7 +714,8 @@ bool App::task_update_event(const TaskUpdateEvent kind, tdc::Task& task) const {
 
             task.set_content(string_input("Content: "));
 
-            m_task_db->update_object(task);
+            m_writes->submit(
+                [this, task] { m_task_writer->update_object(task); });
 
             m_printer->msg_print("Db updated successfully!");
             tdu::sleep(2000);
@@ -325,7 +723,8 @@ bool App::task_update_event(const TaskUpdateEvent kind, tdc::Task& task) const {
         } break;
         case TaskUpdateEvent::DeadlineUpdate: {
             task.set_deadline(datetime_validation_event("Deadline: "));
-            m_task_db->update_object(task);
+            m_writes->submit(
+                [this, task] { m_task_writer->update_object(task); });
 
             m_printer->msg_print("Db updated successfully!");
             tdu::sleep(2000);
@@ -333,7 +732,8 @@ bool App::task_update_event(const TaskUpdateEvent kind, tdc::Task& task) const {
         } break;
         case TaskUpdateEvent::ExecutorUpdate: {
             task.set_executor(executor_choosing_event().id());
-            m_task_db->update_object(task);
+            m_writes->submit(
+                [this, task] { m_task_writer->update_object(task); });
 
             m_printer->msg_print("Db updated successfully!");
             tdu::sleep(2000);
@@ -343,7 +743,10 @@ bool App::task_update_event(const TaskUpdateEvent kind, tdc::Task& task) const {
             m_printer->msg_print("Are you 100% sure ? [y/n]\n");
             const auto confirmation = m_input_handler->get_input();
             if (confirmation == YES) {
-                m_task_db->delete_object(task.id());
+                m_writes->submit([this, id = task.id()] {
+                    m_task_writer->delete_object(id);
+                    m_message_writer->delete_all_by_task_id(id);
+                });
             } else if (confirmation == NO) {
                 return false;
             } else {
@@ -366,7 +769,8 @@ bool App::task_completion_event(tdc::Task& task) const {
 
     if (choice == "y") {
         task.set_is_done(true);
-        m_task_db->update_object(task);
+        m_writes->submit(
+            [this, task] { m_task_writer->update_object(task); });
 
         m_printer->msg_print("Congrats you've completed the task!");
         tdu::sleep(2000);
@@ -380,55 +784,96 @@ bool App::task_completion_event(tdc::Task& task) const {
 }
 
 void App::discussion_event(const tdc::Task& task) const {
-    std::atomic<bool> should_close(false);
-    std::atomic<unsigned int> last_msg_id(0);
-
-    auto receive_msg = [&]() {
-        while (!should_close) {
-            const auto new_msg = m_message_db->get_newest_object();
+    auto receive_msg = [&](std::stop_token stop) {
+        // A connection of its own, so reads here never race the writer
+        // thread's statements or wait for its commits. The writer's commits
+        // reach its notifier as they happen.
+        const auto reader = m_pool->acquire_reader();
+        const tdc::MessageDb chat{reader.connection()};
+        unsigned int last_id = 0;
+        tdu::TimePointChars timestamp;
+
+        // Prints messages from the start of the line, over the pending
+        // prompt, and puts the prompt back after them.
+        const auto print_messages = [&](const Vector<tdc::Message>& messages) {
+            for (const auto& message : messages) {
+                m_printer->msg_print(fmt::format(
+                    "\r[{}] <{}>: {}\n",
+                    tdu::format_time_point(message.timestamp<TimePoint>(),
+                                           timestamp),
+                    message.sender_name(), message.content()));
+                last_id = message.message_id();
+            }
 
-            if (new_msg.has_value() &&
-                new_msg.value().message_id() > last_msg_id) {
-                tdu::clear_term();
+            m_printer->msg_print(
+                fmt::format("<{}>: ", m_current_user->username()));
+        };
 
-                last_msg_id = new_msg.value().message_id();
+        // Read the version before loading, so a message that lands in
+        // between still wakes the wait below.
+        std::uint64_t seen = chat.change_version();
 
-                const auto messages = m_message_db->get_all_objects(task.id());
+        tdu::clear_term();
+        print_messages(chat.get_last_n(task.id(), CHAT_HISTORY_SIZE));
 
-                for (const auto& message : messages) {
-                    m_printer->msg_print(fmt::format(
-                        "[{}] <{}>: {}\n",
-                        tdu::to_string(message.timestamp<TimePoint>()),
-                        message.sender_name(), message.content()));
-                }
+        while (!stop.stop_requested()) {
+            seen = chat.wait_for_change(seen, stop);
 
-                m_printer->msg_print(
-                    fmt::format("<{}>: ", m_current_user->username()));
+            // Changes in other discussions wake us too; skip those cheaply.
+            const auto newest = chat.get_newest_id(task.id());
+            if (stop.stop_requested() || !newest || *newest <= last_id) {
+                continue;
             }
 
-            tdu::sleep(100);
+            print_messages(chat.get_messages_since(task.id(), last_id));
         }
     };
 
-    auto send_msg = [&]() {
-        while (!should_close) {
-            std::string sent_message = m_input_handler->get_input();
-            if (sent_message == "0") {
-                should_close = true;
-                break;
-            }
+    // Destroying the thread requests a stop, which wakes it from the wait.
+    std::jthread receive_thread{receive_msg};
 
-            m_message_db->add_object(
-                tdc::Message{task.id(), m_current_user->username(),
-                             sent_message, tdu::get_current_timestamp()});
+    while (true) {
+        std::string sent_message = m_input_handler->get_input();
+        if (sent_message == "0") {
+            break;
         }
-    };
 
-    std::thread receive_thread = std::thread(receive_msg);
-    std::thread send_thread = std::thread(send_msg);
+        m_writes->submit(
+            [this, message = tdc::Message{
+                       task.id(), String{m_current_user->username()},
+                       std::move(sent_message), tdu::get_current_timestamp()}] {
+                m_message_writer->add_object(message);
+            });
+    }
+}
 
-    receive_thread.join();
-    send_thread.join();
+// Runs on the writer thread, so it only prints and logs.
+void App::write_error_event(std::exception_ptr error) const {
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::exception& e) {
+        tdu::log_to_file(e.what(), fs::current_path().root_path() /
+                                       ENV_FOLDER_NAME / ERR_LOGS_FILE_NAME);
+        m_printer->err_print(
+            fmt::format("\nA change could not be saved: {}\n", e.what()));
+    }
+}
+
+// Runs on the scheduler's thread, so it only prints.
+void App::reminder_event(const unsigned int user_id,
+                         const tdc::Reminder& reminder) const {
+    if (reminder.executor_id != user_id && reminder.owner_id != user_id) {
+        return;
+    }
+
+    tdu::TimePointChars deadline;
+    const bool overdue = reminder.kind == tdc::Reminder::Kind::Overdue;
+    m_printer->msg_print(fmt::format(
+        "\n{} \"{}\" {} {}\n",
+        fmt::styled("[Reminder]",
+                    fg(overdue ? fmt::color::red : fmt::color::yellow)),
+        reminder.topic, overdue ? "was due at" : "is due at",
+        tdu::format_time_point(reminder.deadline, deadline)));
 }
 
 String App::username_validation_event() const {
@@ -659,11 +1104,11 @@ void App::sing_up() const {
     const String username = username_validation_event();
     const String password = password_validation_event();
 
-    if (is_first_user()) {
-        m_user_db->add_object(tdc::User{username, tdc::Role::Admin, password});
-    } else {
-        m_user_db->add_object(tdc::User{username, tdc::Role::User, password});
-    }
+    const tdc::Role role =
+        is_first_user() ? tdc::Role::Admin : tdc::Role::User;
+    m_writes->submit([this, user = tdc::User{username, role, password}] {
+        m_user_writer->add_object(user);
+    });
 
     m_printer->msg_print("\nSuccessfully added user!");
     tdu::sleep(2000);
@@ -674,8 +1119,28 @@ bool App::is_first_user() const {
 }
 
 bool App::is_task_accessible(const tdc::Task& task) const {
-    return !task.is_done() &&
-               task.deadline<TimePoint>() > tdu::get_current_timestamp() ||
-           m_current_user->id() == task.owner_id();
+    return is_task_accessible(task.owner_id(), task.deadline<TimePoint>(),
+                              task.is_done());
+}
+
+bool App::is_task_accessible(const tdc::TaskSummary& summary) const {
+    return is_task_accessible(summary.owner_id(), summary.deadline(),
+                              summary.is_done());
+}
+
+bool App::is_task_accessible(const unsigned int owner_id,
+                             const TimePoint deadline,
+                             const bool is_done) const {
+    return (!is_done && deadline > tdu::get_current_timestamp()) ||
+           m_current_user->id() == owner_id;
+}
+
+tdc::Task& App::open_task(std::optional<tdc::Task>& slot,
+                          const unsigned int id) const {
+    if (!slot) {
+        slot = m_task_db->get_object(id);
+    }
+
+    return *slot;
 }
 }  // namespace twodo
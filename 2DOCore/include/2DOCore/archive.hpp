@@ -0,0 +1,77 @@
+#pragma once
+
+#include <memory>
+
+#include <2DOCore/cursor.hpp>
+#include <2DOCore/database.hpp>
+#include <2DOCore/task.hpp>
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace twodocore {
+struct [[nodiscard]] ArchiveStats {
+    unsigned int tasks;
+    unsigned int messages;
+    NanoSeconds elapsed;
+};
+
+// Done tasks and their messages moved out of the hot tables into a second
+// database file, attached to the connection as "archive" for as long as the
+// archive lives. The tasks and messages tables, their indexes and the
+// identity maps over them then only hold work still in progress; archived
+// rows are read back on demand and are no longer searched, reminded of or
+// edited.
+class [[nodiscard]] TaskArchive {
+  public:
+    TaskArchive(const TaskArchive&) = delete;
+    TaskArchive& operator=(const TaskArchive&) = delete;
+
+    // The file must exist, as the connection is not allowed to create files;
+    // an empty one is set up on first use. It takes the journal mode and
+    // synchronous setting of the connection's profile. Archived rows are
+    // read back through reader when given, which is attached to the file
+    // too; the connection then only moves and clears.
+    TaskArchive(std::shared_ptr<Connection> connection,
+                const fs::path& archive_path,
+                const sch::days archive_after,
+                std::shared_ptr<Connection> reader = nullptr);
+
+    ~TaskArchive();
+
+    [[nodiscard]] sch::days archive_after() const { return m_archive_after; }
+    void set_archive_after(const sch::days age) { m_archive_after = age; }
+
+    // Moves every task marked done at or before now minus archive_after,
+    // with its messages. The copy and the delete commit separately, so a
+    // crash in between leaves rows in both files rather than in neither;
+    // the next run finishes the move. Must not run inside a transaction;
+    // other threads' transactions on the connection wait until it is done.
+    ArchiveStats archive_done(const TimePoint now) const;
+
+    // Archived tasks the user owns or executes, in id order, paged like
+    // TaskDb::stream_all_objects.
+    [[nodiscard]] Cursor<Task> stream_tasks(const unsigned int user_id,
+                                            const unsigned int after_id = 0,
+                                            const int limit = -1) const;
+
+    // The whole discussion of an archived task, oldest first.
+    [[nodiscard]] Vector<Message> get_messages(
+        const unsigned int task_id) const;
+
+    [[nodiscard]] unsigned int task_count() const;
+
+    // Keeps new tasks and messages from taking the id of an archived one,
+    // which a later move would overwrite. Done on construction; needed again
+    // whenever the main file is replaced, as by a snapshot restore, which
+    // rolls the id counters back.
+    void reserve_archived_ids() const;
+
+    // Empties the archive, for a wipe of all data.
+    void clear() const;
+
+  private:
+    std::shared_ptr<Connection> m_connection;
+    std::shared_ptr<Connection> m_reader;
+    sch::days m_archive_after;
+};
+}  // namespace twodocore
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+
+#include <SQLiteCpp/Backup.h>
+#include <SQLiteCpp/Database.h>
+
+#include <2DOCore/database.hpp>
+#include <2DOCore/pool.hpp>
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace twodocore {
+inline constexpr int BACKUP_STEP_PAGES = 64;
+inline constexpr sch::milliseconds BACKUP_STEP_PAUSE{20};
+inline constexpr StringView SNAPSHOT_PREFIX = "2do_snapshot_";
+inline constexpr StringView SNAPSHOT_EXTENSION = ".db3";
+
+// Copies a live database into a file a few pages per step, so the source is
+// locked only for the length of one step. A step holds the source
+// connection's lock, so it never copies a transaction left open on it.
+// Writes made through the same connection in between are carried into the
+// copy; a write from another connection makes the next step start over. The
+// copy is not synced to disk.
+class [[nodiscard]] OnlineBackup {
+  public:
+    OnlineBackup(const OnlineBackup&) = delete;
+    OnlineBackup& operator=(const OnlineBackup&) = delete;
+
+    OnlineBackup(Connection& source, const fs::path& path);
+
+    // Copies up to pages pages. Returns true once the copy is complete.
+    bool step(const int pages = BACKUP_STEP_PAGES);
+
+    [[nodiscard]] int remaining_pages() const {
+        return m_backup.getRemainingPageCount();
+    }
+    [[nodiscard]] int total_pages() const {
+        return m_backup.getTotalPageCount();
+    }
+
+  private:
+    Connection& m_source;
+    SQL::Database m_target;
+    SQL::Backup m_backup;
+};
+
+struct [[nodiscard]] Snapshot {
+    fs::path path;
+    // UTC time the snapshot was started, "YYYY-MM-DD_hh-mm-ss.mmm".
+    String name;
+};
+
+// Timestamped snapshots of a connection's database kept in one folder, the
+// newest keep of them. A snapshot is written under a temporary name and
+// renamed once complete, so a listed snapshot is always whole.
+class [[nodiscard]] SnapshotStore {
+  public:
+    SnapshotStore(const SnapshotStore&) = delete;
+    SnapshotStore& operator=(const SnapshotStore&) = delete;
+
+    SnapshotStore(std::shared_ptr<Connection> connection,
+                  fs::path folder,
+                  const std::size_t keep);
+
+    // Snapshots are copied through a reader leased for each one, and
+    // restored through the pool's writer. Under WAL the copy is read from a
+    // single snapshot of the database, so commits made meanwhile neither
+    // restart it nor wait for it.
+    SnapshotStore(std::shared_ptr<ConnectionPool> pool,
+                  fs::path folder,
+                  const std::size_t keep);
+
+    // Newest first.
+    [[nodiscard]] Vector<Snapshot> list() const;
+
+    [[nodiscard]] std::size_t keep() const;
+    // Deletes the snapshots past the new limit at once. At least one is
+    // always kept.
+    void set_keep(const std::size_t keep);
+
+    // Copies the database BACKUP_STEP_PAGES pages at a time with
+    // BACKUP_STEP_PAUSE in between, then drops snapshots past the limit.
+    // Returns nullopt, leaving nothing behind, when stop is requested first.
+    std::optional<Snapshot> take(std::stop_token stop = {});
+
+    // Replaces the database with the snapshot in a single step and sends a
+    // Reset to the connection's listeners.
+    void restore(const Snapshot& snapshot);
+
+    // Takes a snapshot on a background thread every interval, and as soon
+    // as possible after request(). The thread stops when the store is
+    // destroyed, abandoning a snapshot in progress.
+    void start(const sch::minutes interval);
+    void request();
+
+  private:
+    std::shared_ptr<ConnectionPool> m_pool = nullptr;
+    std::shared_ptr<Connection> m_connection;
+    const fs::path m_folder;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable_any m_wake;
+    std::size_t m_keep;
+    bool m_requested = false;
+
+    // Held for a whole take or restore, so they never overlap.
+    std::mutex m_job_mutex;
+
+    // Last, so it is joined before anything it uses goes away.
+    std::jthread m_thread{};
+
+    void prune(const std::size_t keep) const;
+};
+}  // namespace twodocore
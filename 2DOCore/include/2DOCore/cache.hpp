@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+
+#include <2DOCore/database.hpp>
+#include <Utils/type.hpp>
+
+namespace twodocore {
+struct [[nodiscard]] CacheStats {
+    std::size_t hits;
+    std::size_t misses;
+};
+
+// Id to object map in front of a repository. The repository writes through
+// on its own changes and the connection's change listener evicts anything
+// else, so a lookup never returns a row the database no longer holds.
+//
+// Fills after a read carry the generation seen before the read; if anything
+// was evicted in between, the fill is dropped rather than caching a row that
+// may already be stale.
+template <typename T>
+class [[nodiscard]] IdentityMap {
+  public:
+    [[nodiscard]] std::uint64_t generation() const {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return m_generation;
+    }
+
+    [[nodiscard]] std::optional<T> find(const unsigned int id) {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        if (const auto it = m_objects.find(id); it != m_objects.end()) {
+            ++m_hits;
+            return it->second;
+        }
+
+        ++m_misses;
+        return std::nullopt;
+    }
+
+    // Every row of the table in id order, once a full read has been cached.
+    [[nodiscard]] std::optional<Vector<T>> find_all() {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        if (!m_complete) {
+            ++m_misses;
+            return std::nullopt;
+        }
+
+        ++m_hits;
+        Vector<T> objects;
+        objects.reserve(m_objects.size());
+        for (const auto& [id, object] : m_objects) {
+            objects.push_back(object);
+        }
+
+        return objects;
+    }
+
+    void fill(const unsigned int id,
+              const T& object,
+              const std::uint64_t generation) {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        if (generation == m_generation) {
+            m_objects.insert_or_assign(id, object);
+        }
+    }
+
+    template <typename IdOf>
+    void fill_all(const Vector<T>& objects,
+                  const std::uint64_t generation,
+                  IdOf id_of) {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        if (generation != m_generation) {
+            return;
+        }
+
+        m_objects.clear();
+        for (const auto& object : objects) {
+            m_objects.insert_or_assign(id_of(object), object);
+        }
+        m_complete = true;
+    }
+
+    // Write-through after a successful write of our own.
+    void put(const unsigned int id, const T& object) {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_objects.insert_or_assign(id, object);
+    }
+
+    void erase(const unsigned int id) {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        m_objects.erase(id);
+        ++m_generation;
+    }
+
+    void apply(const Change change, const int64_t rowid) {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        switch (change) {
+            case Change::Insert:
+                m_complete = false;
+                break;
+            case Change::Update:
+                m_objects.erase(static_cast<unsigned int>(rowid));
+                m_complete = false;
+                break;
+            case Change::Delete:
+                m_objects.erase(static_cast<unsigned int>(rowid));
+                break;
+            case Change::Reset:
+                m_objects.clear();
+                m_complete = false;
+                break;
+        }
+        ++m_generation;
+    }
+
+    [[nodiscard]] CacheStats stats() const {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return CacheStats{m_hits, m_misses};
+    }
+
+  private:
+    mutable std::mutex m_mutex;
+    std::map<unsigned int, T> m_objects{};
+    bool m_complete = false;
+    std::uint64_t m_generation = 0;
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+};
+
+// Subscribes map to the changes of one table on connection.
+template <typename T>
+[[nodiscard]] ChangeSubscription watch_table(Connection& connection,
+                                             StringView table,
+                                             IdentityMap<T>& map) {
+    return connection.subscribe(
+        [table, &map](const Change change, StringView changed,
+                      const int64_t rowid) {
+            if (change == Change::Reset || changed == table) {
+                map.apply(change, rowid);
+            }
+        });
+}
+}  // namespace twodocore
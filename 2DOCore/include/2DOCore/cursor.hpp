@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+
+#include <SQLiteCpp/Statement.h>
+
+namespace SQL = SQLite;
+
+namespace twodocore {
+// Lazy single-pass range over a query result. Each increment steps the
+// statement once, so only the current row is materialized.
+template <typename T>
+class [[nodiscard]] Cursor {
+  public:
+    using Decoder = T (*)(const SQL::Statement&);
+
+    class Iterator {
+      public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using iterator_concept = std::input_iterator_tag;
+
+        Iterator() = default;
+        explicit Iterator(Cursor* cursor) : m_cursor{cursor} {}
+
+        T& operator*() const { return *m_cursor->m_current; }
+        T* operator->() const { return &*m_cursor->m_current; }
+
+        Iterator& operator++() {
+            m_cursor->advance();
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(std::default_sentinel_t) const {
+            return !m_cursor || !m_cursor->m_current;
+        }
+
+      private:
+        Cursor* m_cursor = nullptr;
+    };
+
+    Cursor(const Cursor&) = delete;
+    Cursor& operator=(const Cursor&) = delete;
+    Cursor(Cursor&&) = default;
+    Cursor& operator=(Cursor&&) = default;
+
+    Cursor(std::unique_ptr<SQL::Statement> statement, const Decoder decode)
+        : m_statement{std::move(statement)}, m_decode{decode} {}
+
+    Iterator begin() {
+        if (!m_started) {
+            m_started = true;
+            advance();
+        }
+        return Iterator{this};
+    }
+
+    std::default_sentinel_t end() const { return {}; }
+
+  private:
+    std::unique_ptr<SQL::Statement> m_statement;
+    Decoder m_decode;
+    std::optional<T> m_current{};
+    bool m_started = false;
+
+    void advance() {
+        if (m_statement->executeStep()) {
+            m_current.emplace(m_decode(*m_statement));
+        } else {
+            m_current.reset();
+        }
+    }
+};
+}  // namespace twodocore
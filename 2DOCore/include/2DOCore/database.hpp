@@ -0,0 +1,276 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace SQL = SQLite;
+
+namespace twodocore {
+template <typename R, typename T>
+concept RangeOf =
+    std::ranges::input_range<R> &&
+    std::same_as<std::remove_cvref_t<std::ranges::range_reference_t<R>>, T>;
+
+class Connection;
+
+// A statement lent out by a StatementCache. It holds the connection's lock
+// until released, so no other thread runs it, or reads the connection's
+// last insert rowid, in the meantime.
+class [[nodiscard]] CachedStatement {
+  public:
+    CachedStatement(const CachedStatement&) = delete;
+    CachedStatement& operator=(const CachedStatement&) = delete;
+
+    CachedStatement(SQL::Statement& statement,
+                    std::unique_lock<std::recursive_mutex> lock)
+        : m_statement{&statement}, m_lock{std::move(lock)} {}
+
+    CachedStatement(CachedStatement&& other) noexcept
+        : m_statement{std::exchange(other.m_statement, nullptr)},
+          m_lock{std::move(other.m_lock)} {}
+
+    // Resetting on release closes the read cursor so the connection does not
+    // keep a read transaction open between calls.
+    ~CachedStatement() {
+        if (m_statement) {
+            m_statement->tryReset();
+        }
+    }
+
+    SQL::Statement* operator->() const { return m_statement; }
+    SQL::Statement& operator*() const { return *m_statement; }
+
+  private:
+    SQL::Statement* m_statement;
+    std::unique_lock<std::recursive_mutex> m_lock;
+};
+
+class [[nodiscard]] StatementCache {
+  public:
+    StatementCache(const StatementCache&) = delete;
+    StatementCache& operator=(const StatementCache&) = delete;
+
+    explicit StatementCache(Connection& connection)
+        : m_connection{connection} {}
+
+    // Waits for the connection's lock, which the statement then holds.
+    [[nodiscard]] CachedStatement acquire(StringView sql);
+
+    [[nodiscard]] std::size_t size() const;
+
+  private:
+    // Transparent so a lookup by view does not build a key string.
+    struct SqlHash {
+        using is_transparent = void;
+
+        std::size_t operator()(StringView sql) const {
+            return std::hash<StringView>{}(sql);
+        }
+    };
+
+    Connection& m_connection;
+    mutable std::mutex m_mutex;
+    std::unordered_map<String,
+                       std::unique_ptr<SQL::Statement>,
+                       SqlHash,
+                       std::equal_to<>>
+        m_statements{};
+};
+
+// PRAGMA settings applied when a connection is opened.
+struct [[nodiscard]] ConnectionProfile {
+    StringView name;
+    StringView journal_mode;
+    StringView synchronous;
+    int64_t mmap_size;
+    int cache_size_kib;
+    StringView temp_store;
+    int busy_timeout_ms;
+};
+
+// WAL with a full fsync on every commit. Every preset uses WAL, so pooled
+// readers never lock the writer out.
+inline constexpr ConnectionProfile DURABLE_PROFILE{
+    "durable", "WAL", "FULL", 0, 2'000, "DEFAULT", 5'000};
+// WAL syncs only at checkpoints; a power loss may drop the last commits but
+// never corrupts the file.
+inline constexpr ConnectionProfile BALANCED_PROFILE{
+    "balanced", "WAL", "NORMAL", 64 << 20, 8'000, "MEMORY", 5'000};
+// No fsync at all; an OS crash may lose recent commits.
+inline constexpr ConnectionProfile FAST_PROFILE{
+    "fast", "WAL", "OFF", 256 << 20, 32'000, "MEMORY", 5'000};
+
+inline constexpr Array<ConnectionProfile, 3> CONNECTION_PROFILES = {
+    DURABLE_PROFILE, BALANCED_PROFILE, FAST_PROFILE};
+
+[[nodiscard]] std::optional<ConnectionProfile> find_connection_profile(
+    StringView name);
+
+// A row change seen on a connection. Reset means any row may have changed:
+// after a rollback, or a DELETE without WHERE, which skips the update hook.
+enum class Change { Insert, Update, Delete, Reset };
+
+// Called with the table name, empty for Reset, and the rowid.
+using ChangeListener =
+    std::function<void(Change change, StringView table, int64_t rowid)>;
+
+class WriteQueue;
+
+// Keeps a ChangeListener registered until destroyed.
+class [[nodiscard]] ChangeSubscription {
+  public:
+    ChangeSubscription(const ChangeSubscription&) = delete;
+    ChangeSubscription& operator=(const ChangeSubscription&) = delete;
+
+    ChangeSubscription(Connection& connection, const unsigned int id)
+        : m_connection{&connection}, m_id{id} {}
+
+    ChangeSubscription(ChangeSubscription&& other) noexcept
+        : m_connection{std::exchange(other.m_connection, nullptr)},
+          m_id{other.m_id} {}
+
+    ChangeSubscription& operator=(ChangeSubscription&& other) noexcept;
+
+    ~ChangeSubscription();
+
+  private:
+    Connection* m_connection;
+    unsigned int m_id;
+};
+
+// A writer applies the whole profile and brings the schema up to date. A
+// reader opens the file read-only and leaves the journal mode, syncing and
+// schema to the writer, so the database must already exist.
+enum class ConnectionRole { Writer, Reader };
+
+// One SQLite connection shared by every repository of a session. Opening it
+// applies the profile and brings the schema up to date.
+class [[nodiscard]] Connection {
+  public:
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    explicit Connection(const fs::path& db_filepath,
+                        const ConnectionProfile& profile = BALANCED_PROFILE,
+                        const ConnectionRole role = ConnectionRole::Writer);
+
+    ~Connection();
+
+    [[nodiscard]] SQL::Database& db() { return m_db; }
+    [[nodiscard]] const SQL::Database& db() const { return m_db; }
+
+    [[nodiscard]] const ConnectionProfile& profile() const {
+        return m_profile;
+    }
+    [[nodiscard]] ConnectionRole role() const { return m_role; }
+
+    // Listeners run inside the statement that made the change, on its
+    // thread, and must not use the connection themselves.
+    [[nodiscard]] ChangeSubscription subscribe(ChangeListener listener);
+
+    // Like subscribe, but the changes of a transaction arrive only once it
+    // has committed, when other connections can read them. Changes undone
+    // by a rolled-back savepoint may still arrive.
+    [[nodiscard]] ChangeSubscription subscribe_committed(
+        ChangeListener listener);
+
+    // Makes this connection, a reader of the same file, pass on to its own
+    // listeners the changes writer commits, and wait in await_own_writes for
+    // the writes this thread queued on writer's WriteQueue. Caches over the
+    // reader then stay current without polling.
+    void follow(std::shared_ptr<Connection> writer);
+
+    // Any row may have changed. Listeners of subscribe_committed hear it
+    // after the commit, or at once outside a transaction.
+    void notify_reset();
+
+    // Held by every UnitOfWork and CachedStatement for as long as it lives,
+    // so threads sharing the connection take turns: none sees another's open
+    // transaction or runs a statement another is using. Recursive, as units
+    // of work nest and run cached statements. Take it as well around other
+    // work that must not interleave, such as a backup or a VACUUM.
+    [[nodiscard]] std::unique_lock<std::recursive_mutex> lock() {
+        return std::unique_lock<std::recursive_mutex>{m_mutex};
+    }
+
+    // Blocks until the writes this thread queued on the connection's
+    // WriteQueue, or on the one of the writer it follows, have been
+    // committed. Repositories call it before every read.
+    void await_own_writes() const;
+
+  private:
+    struct PendingChange {
+        Change change;
+        String table;
+        int64_t rowid;
+    };
+
+    SQL::Database m_db;
+    ConnectionProfile m_profile;
+    ConnectionRole m_role;
+    std::recursive_mutex m_mutex;
+    std::atomic<const WriteQueue*> m_write_queue{nullptr};
+    std::mutex m_listeners_mutex;
+    HashMap<unsigned int, ChangeListener> m_listeners{};
+    HashMap<unsigned int, ChangeListener> m_commit_listeners{};
+    // Changes of the open transaction, kept only while anyone listens for
+    // commits.
+    Vector<PendingChange> m_uncommitted{};
+    unsigned int m_next_listener_id = 0;
+    std::shared_ptr<Connection> m_writer = nullptr;
+    // Last, so the writer stops calling in before anything it uses goes.
+    std::optional<ChangeSubscription> m_following{};
+
+    void apply_profile();
+    void notify(Change change, StringView table, int64_t rowid);
+    // Listeners of subscribe_committed never saw the rolled-back changes;
+    // those of a whole transaction are dropped, those of a savepoint cannot
+    // be told apart and go out with the next commit.
+    void notify_rollback(const bool transaction_ended);
+    void notify_committed();
+    void unsubscribe(const unsigned int id);
+
+    friend class ChangeSubscription;
+    friend class UnitOfWork;
+    friend class WriteQueue;
+};
+
+// Scoped transaction that rolls back unless committed. Built on SAVEPOINT so
+// units of work nest: only the outermost commit reaches the disk.
+class [[nodiscard]] UnitOfWork {
+  public:
+    UnitOfWork(const UnitOfWork&) = delete;
+    UnitOfWork& operator=(const UnitOfWork&) = delete;
+
+    explicit UnitOfWork(SQL::Database& db);
+    // Holds the connection's lock until committed or rolled back. Rolling
+    // back also sends a Reset to the connection's listeners, as ROLLBACK TO
+    // does not fire SQLite's rollback hook.
+    explicit UnitOfWork(Connection& connection);
+
+    ~UnitOfWork();
+
+    void commit();
+
+  private:
+    SQL::Database& m_db;
+    Connection* m_connection = nullptr;
+    std::unique_lock<std::recursive_mutex> m_lock{};
+    bool m_done = false;
+};
+}  // namespace twodocore
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <SQLiteCpp/Database.h>
+
+#include <Utils/type.hpp>
+
+namespace SQL = SQLite;
+
+namespace twodocore {
+struct [[nodiscard]] Migration {
+    unsigned int version;
+    StringView description;
+    StringView sql;
+};
+
+// Ordered list of schema upgrades. Versions are strictly increasing and a
+// migration is never edited once shipped; add a new one instead.
+[[nodiscard]] const Vector<Migration>& migrations();
+
+[[nodiscard]] unsigned int schema_version(const SQL::Database& db);
+
+// Creates the base tables when missing and applies every migration newer than
+// the recorded schema version. Either all pending migrations apply or none.
+void migrate(SQL::Database& db);
+}  // namespace twodocore
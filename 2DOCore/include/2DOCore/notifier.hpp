@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+
+#include <2DOCore/database.hpp>
+#include <Utils/type.hpp>
+
+namespace twodocore {
+// Version counter for one table that waiters can block on. Changes made on
+// the connection, or committed by the writer it follows, arrive through its
+// change listeners and wake waiters at once. Commits from other processes
+// are only visible through PRAGMA data_version, which a waiter checks each
+// time poll_interval passes idle.
+class [[nodiscard]] ChangeNotifier {
+  public:
+    ChangeNotifier(const ChangeNotifier&) = delete;
+    ChangeNotifier& operator=(const ChangeNotifier&) = delete;
+
+    ChangeNotifier(Connection& connection,
+                   StringView table,
+                   const sch::milliseconds poll_interval = sch::seconds{1});
+
+    [[nodiscard]] std::uint64_t version() const;
+
+    // Returns the new version once it differs from seen, or the current one
+    // when stop is requested.
+    std::uint64_t wait(const std::uint64_t seen, std::stop_token stop);
+
+  private:
+    Connection& m_connection;
+    const sch::milliseconds m_poll_interval;
+    mutable std::mutex m_mutex;
+    std::condition_variable_any m_changed;
+    std::uint64_t m_version = 0;
+    int64_t m_data_version;
+    ChangeSubscription m_subscription;
+
+    [[nodiscard]] int64_t read_data_version() const;
+    void bump();
+};
+}  // namespace twodocore
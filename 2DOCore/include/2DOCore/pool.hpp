@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <2DOCore/database.hpp>
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace twodocore {
+inline constexpr std::size_t POOL_MAX_READERS = 8;
+
+struct [[nodiscard]] PoolStats {
+    std::size_t open_readers;
+    std::size_t leased_readers;
+};
+
+class ConnectionPool;
+
+// A reader connection lent to one thread, given back to the pool when the
+// lease is destroyed. Repositories built over it must go first.
+class [[nodiscard]] ReaderLease {
+  public:
+    ReaderLease(const ReaderLease&) = delete;
+    ReaderLease& operator=(const ReaderLease&) = delete;
+
+    ReaderLease(ConnectionPool& pool, std::shared_ptr<Connection> connection)
+        : m_pool{&pool}, m_connection{std::move(connection)} {}
+
+    ReaderLease(ReaderLease&& other) noexcept
+        : m_pool{std::exchange(other.m_pool, nullptr)},
+          m_connection{std::move(other.m_connection)} {}
+
+    // Gives back the reader held so far.
+    ReaderLease& operator=(ReaderLease&& other) noexcept;
+
+    ~ReaderLease();
+
+    [[nodiscard]] const std::shared_ptr<Connection>& connection() const {
+        return m_connection;
+    }
+
+  private:
+    ConnectionPool* m_pool;
+    std::shared_ptr<Connection> m_connection;
+};
+
+// The connections of one database file: a single writer shared by the
+// session, and read-only connections leased out one per thread. Under WAL
+// each reader reads from its own snapshot, so reads never wait for a write
+// and a long read never holds up a commit; under a rollback journal they
+// still lock each other out, and only the busy timeout hides it.
+//
+// Readers follow the writer: what it commits reaches the readers' change
+// listeners right after the commit, so caches and change notifiers over a
+// reader stay current, and a thread reading through one first waits for the
+// writes it queued on the writer's WriteQueue to commit. A read transaction
+// held open across calls must not go through a repository, as its snapshot
+// could refill a cache with what a later commit replaced. The pool must
+// outlive its leases.
+class [[nodiscard]] ConnectionPool {
+  public:
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Opens the writer at once; readers are opened on first demand, up to
+    // max_readers of them.
+    explicit ConnectionPool(const fs::path& db_filepath,
+                            const ConnectionProfile& profile = BALANCED_PROFILE,
+                            const std::size_t max_readers = POOL_MAX_READERS);
+
+    [[nodiscard]] const std::shared_ptr<Connection>& writer() const {
+        return m_writer;
+    }
+
+    // Lends an idle reader, opening a new one while under max_readers, or
+    // waits for one to come back.
+    [[nodiscard]] ReaderLease acquire_reader();
+
+    [[nodiscard]] PoolStats stats() const;
+
+  private:
+    const fs::path m_db_filepath;
+    const ConnectionProfile m_profile;
+    const std::size_t m_max_readers;
+    std::shared_ptr<Connection> m_writer;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_returned;
+    Vector<std::shared_ptr<Connection>> m_idle{};
+    std::size_t m_open = 0;
+
+    void release(std::shared_ptr<Connection> connection);
+
+    friend class ReaderLease;
+};
+}  // namespace twodocore
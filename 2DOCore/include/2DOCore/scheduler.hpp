@@ -0,0 +1,146 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+
+#include <2DOCore/database.hpp>
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace tdu = twodoutils;
+
+namespace twodocore {
+// Hierarchical timing wheel over epoch minutes, one timer per id. Level l
+// has 64 slots of 64^l minutes each; a timer sits at the highest level
+// where its due time differs from now and moves down as that slot comes
+// round, so scheduling, cancelling and expiry are all O(1) amortized.
+class [[nodiscard]] TimerWheel {
+  public:
+    struct Timer {
+        unsigned int id;
+        int64_t due;
+    };
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    explicit TimerWheel(const int64_t now) : m_now{now} {}
+
+    [[nodiscard]] int64_t now() const { return m_now; }
+    [[nodiscard]] std::size_t size() const { return m_index.size(); }
+
+    // Replaces any timer for id. A due time not after now fires on the next
+    // advance.
+    void schedule(const unsigned int id, const int64_t due);
+    bool cancel(const unsigned int id);
+    void clear();
+
+    // Moves time forward to now and returns the timers that came due, in
+    // tick order.
+    [[nodiscard]] Vector<Timer> advance(const int64_t now);
+
+  private:
+    static constexpr int SLOT_BITS = 6;
+    static constexpr std::size_t SLOTS = 1 << SLOT_BITS;
+    static constexpr std::size_t LEVELS = 4;
+
+    using Slot = std::list<Timer>;
+
+    struct Location {
+        Slot* slot;
+        Slot::iterator timer;
+    };
+
+    int64_t m_now;
+    Array<Array<Slot, SLOTS>, LEVELS> m_levels{};
+    // Past the top level, and not after now, respectively.
+    Slot m_overflow{};
+    Slot m_expired{};
+    HashMap<unsigned int, Location> m_index{};
+
+    // The next tick on which a timer may fire or move down a level, so
+    // advance can skip the empty stretches in between.
+    [[nodiscard]] int64_t next_tick() const;
+    [[nodiscard]] Slot& slot_for(const int64_t due);
+    // Moves the timers of one slot to where they belong now, without
+    // reallocating them.
+    void cascade(Slot& slot);
+    void collect(Slot& slot, Vector<Timer>& fired);
+};
+
+struct [[nodiscard]] Reminder {
+    enum class Kind { DueSoon, Overdue };
+
+    Kind kind;
+    unsigned int task_id;
+    String topic;
+    TimePoint deadline;
+    unsigned int executor_id;
+    unsigned int owner_id;
+};
+
+using ReminderListener = std::function<void(const Reminder&)>;
+
+// Keeps a TimerWheel of the deadlines of tasks that are not done. A task
+// gets a DueSoon reminder lead_time before its deadline and an Overdue one
+// when it passes; a deadline already past when the task is loaded gets
+// neither, as the task is overdue already.
+//
+// Tasks are loaded on the first poll. Later changes arrive through the
+// connection's update hook, which may not query the database, so they only
+// mark the task; the next poll re-reads marked tasks alone.
+class [[nodiscard]] DeadlineScheduler {
+  public:
+    DeadlineScheduler(const DeadlineScheduler&) = delete;
+    DeadlineScheduler& operator=(const DeadlineScheduler&) = delete;
+
+    DeadlineScheduler(std::shared_ptr<Connection> connection,
+                      const sch::minutes lead_time,
+                      const TimePoint now = tdu::get_current_timestamp());
+
+    [[nodiscard]] std::size_t pending() const;
+
+    // Applies task changes seen since the last poll and returns the
+    // reminders due by now.
+    [[nodiscard]] Vector<Reminder> poll(const TimePoint now);
+
+    // Polls on a background thread at every minute, and at once when tasks
+    // change, passing each reminder to listener. The thread stops when the
+    // scheduler is destroyed.
+    void start(ReminderListener listener);
+
+  private:
+    std::shared_ptr<Connection> m_connection;
+    std::unique_ptr<StatementCache> m_statements;
+    const sch::minutes m_lead_time;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable_any m_changed;
+    TimerWheel m_wheel;
+    HashMap<unsigned int, int64_t> m_deadlines{};
+    std::unordered_set<unsigned int> m_dirty{};
+    bool m_reload = true;
+
+    ChangeSubscription m_subscription;
+    // Last, so it is joined before anything it uses goes away.
+    std::jthread m_thread{};
+
+    void on_change(const Change change, const int64_t rowid);
+    void track(const unsigned int id, const int64_t deadline);
+    void untrack(const unsigned int id);
+    [[nodiscard]] std::optional<int64_t> read_open_deadline(
+        const unsigned int id) const;
+    [[nodiscard]] std::optional<Reminder> read_reminder(
+        const Reminder::Kind kind,
+        const unsigned int id,
+        const int64_t deadline) const;
+};
+}  // namespace twodocore
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Statement.h>
+#include <sqlite3.h>
+
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace tdu = twodoutils;
+namespace SQL = SQLite;
+
+namespace twodocore {
+// String literal usable as a template argument.
+template <std::size_t N>
+struct FixedString {
+    char chars[N]{};
+
+    constexpr FixedString(const char (&str)[N]) {
+        std::copy_n(str, N, chars);
+    }
+
+    [[nodiscard]] constexpr StringView view() const { return {chars, N - 1}; }
+};
+
+// Converts a member to and from its column. Specialise it to map a new C++
+// type; reads go straight to the sqlite3 API, so no Column objects are made.
+template <typename T>
+struct ColumnCodec;
+
+template <>
+struct ColumnCodec<unsigned int> {
+    static void bind(SQL::Statement& query, int index, unsigned int value) {
+        query.bind(index, value);
+    }
+
+    static void read(sqlite3_stmt* row, int index, unsigned int& value) {
+        value = static_cast<unsigned int>(sqlite3_column_int64(row, index));
+    }
+};
+
+template <>
+struct ColumnCodec<bool> {
+    static void bind(SQL::Statement& query, int index, bool value) {
+        query.bind(index, static_cast<int>(value));
+    }
+
+    static void read(sqlite3_stmt* row, int index, bool& value) {
+        value = sqlite3_column_int(row, index) != 0;
+    }
+};
+
+// Parameters only; the view must outlive the statement step.
+template <>
+struct ColumnCodec<StringView> {
+    static void bind(SQL::Statement& query, int index, StringView value) {
+        const int result = sqlite3_bind_text(
+            query.getPreparedStatement(), index, value.data(),
+            static_cast<int>(value.size()), SQLITE_STATIC);
+        if (result != SQLITE_OK) {
+            throw SQL::Exception("Failed to bind text.", result);
+        }
+    }
+};
+
+// Strings are bound without a copy, and read into the string's own
+// allocator, so String and PmrString members map the same way.
+template <typename Alloc>
+struct ColumnCodec<std::basic_string<char, std::char_traits<char>, Alloc>> {
+    using Text = std::basic_string<char, std::char_traits<char>, Alloc>;
+
+    static void bind(SQL::Statement& query, int index, const Text& value) {
+        ColumnCodec<StringView>::bind(query, index, value);
+    }
+
+    static void read(sqlite3_stmt* row, int index, Text& value) {
+        const auto* text =
+            reinterpret_cast<const char*>(sqlite3_column_text(row, index));
+        value.assign(text ? text : "", sqlite3_column_bytes(row, index));
+    }
+};
+
+template <>
+struct ColumnCodec<TimePoint> {
+    static void bind(SQL::Statement& query, int index, TimePoint value) {
+        query.bind(index, tdu::to_epoch_minutes(value));
+    }
+
+    static void read(sqlite3_stmt* row, int index, TimePoint& value) {
+        value = tdu::from_epoch_minutes(sqlite3_column_int64(row, index));
+    }
+};
+
+template <typename M>
+struct MemberTraits;
+
+template <typename C, typename T>
+struct MemberTraits<T C::*> {
+    using type = T;
+};
+
+// A column and the data member it maps to.
+template <FixedString Name, auto Member>
+struct Field {
+    using type = typename MemberTraits<decltype(Member)>::type;
+
+    static constexpr StringView name = Name.view();
+    static constexpr auto member = Member;
+};
+
+// Specialised next to each mapped type with its table name and its Fields;
+// the first Field is the key. The specialisation is a friend of the type so
+// it can name private members and the private default constructor:
+//
+//   template <>
+//   struct Schema<User> {
+//       static constexpr StringView table = "users";
+//       using Fields = std::tuple<Field<"user_id", &User::m_user_id>, ...>;
+//       static User blank() { return User{}; }
+//   };
+template <typename T>
+struct Schema;
+
+namespace detail {
+template <typename T>
+using Fields = typename Schema<T>::Fields;
+
+template <typename T>
+inline constexpr auto COLUMN_NAMES =
+    []<typename... Fs>(std::type_identity<std::tuple<Fs...>>) {
+        return Array<StringView, sizeof...(Fs)>{Fs::name...};
+    }(std::type_identity<Fields<T>>{});
+
+// Writes SQL text, or only measures it when there is no buffer.
+struct SqlWriter {
+    char* out = nullptr;
+    std::size_t size = 0;
+
+    constexpr void append(StringView text) {
+        for (const char c : text) {
+            if (out) {
+                out[size] = c;
+            }
+            ++size;
+        }
+    }
+
+    // Appends "name, name" or "name = ?, name = ?" for all non-key columns.
+    template <typename T>
+    constexpr void columns(StringView suffix = "") {
+        const auto& names = COLUMN_NAMES<T>;
+        for (std::size_t i = 1; i < names.size(); ++i) {
+            append(i == 1 ? "" : ", ");
+            append(names[i]);
+            append(suffix);
+        }
+    }
+};
+
+template <typename Builder>
+inline constexpr auto SQL_TEXT = [] {
+    constexpr std::size_t length = [] {
+        SqlWriter sql{};
+        Builder::write(sql);
+        return sql.size;
+    }();
+
+    Array<char, length + 1> text{};
+    SqlWriter sql{text.data()};
+    Builder::write(sql);
+    return text;
+}();
+
+template <typename T, FixedString Suffix>
+struct SelectBuilder {
+    static constexpr void write(SqlWriter& sql) {
+        sql.append("SELECT ");
+        sql.append(COLUMN_NAMES<T>[0]);
+        sql.append(COLUMN_NAMES<T>.size() > 1 ? ", " : "");
+        sql.columns<T>();
+        sql.append(" FROM ");
+        sql.append(Schema<T>::table);
+        sql.append(Suffix.view());
+    }
+};
+
+template <typename T>
+struct InsertBuilder {
+    static constexpr void write(SqlWriter& sql) {
+        sql.append("INSERT INTO ");
+        sql.append(Schema<T>::table);
+        sql.append(" (");
+        sql.columns<T>();
+        sql.append(") VALUES (");
+        for (std::size_t i = 1; i < COLUMN_NAMES<T>.size(); ++i) {
+            sql.append(i == 1 ? "?" : ", ?");
+        }
+        sql.append(")");
+    }
+};
+
+template <typename T>
+struct UpdateBuilder {
+    static constexpr void write(SqlWriter& sql) {
+        sql.append("UPDATE ");
+        sql.append(Schema<T>::table);
+        sql.append(" SET ");
+        sql.columns<T>(" = ?");
+        sql.append(" WHERE ");
+        sql.append(COLUMN_NAMES<T>[0]);
+        sql.append(" = ?");
+    }
+};
+}  // namespace detail
+
+// "SELECT <all columns> FROM <table><Suffix>", built at compile time.
+template <typename T, FixedString Suffix = "">
+[[nodiscard]] constexpr const char* select_sql() {
+    return detail::SQL_TEXT<detail::SelectBuilder<T, Suffix>>.data();
+}
+
+// Inserts every column but the key, in schema order.
+template <typename T>
+[[nodiscard]] constexpr const char* insert_sql() {
+    return detail::SQL_TEXT<detail::InsertBuilder<T>>.data();
+}
+
+// Sets every column but the key, then matches on the key.
+template <typename T>
+[[nodiscard]] constexpr const char* update_sql() {
+    return detail::SQL_TEXT<detail::UpdateBuilder<T>>.data();
+}
+
+// Binds the non-key columns to parameters 1..N-1, matching insert_sql.
+template <typename T>
+void bind_columns(SQL::Statement& query, const T& object) {
+    [&]<typename Key, typename... Fs>(
+        std::type_identity<std::tuple<Key, Fs...>>) {
+        int index = 0;
+        (ColumnCodec<typename Fs::type>::bind(query, ++index,
+                                              object.*Fs::member),
+         ...);
+    }(std::type_identity<detail::Fields<T>>{});
+}
+
+// Binds the non-key columns and then the key, matching update_sql.
+template <typename T>
+void bind_columns_and_key(SQL::Statement& query, const T& object) {
+    using Key = std::tuple_element_t<0, detail::Fields<T>>;
+
+    bind_columns(query, object);
+    ColumnCodec<typename Key::type>::bind(
+        query, static_cast<int>(detail::COLUMN_NAMES<T>.size()),
+        object.*Key::member);
+}
+
+namespace detail {
+template <typename T>
+void read_fields(const SQL::Statement& query, T& object) {
+    if (!query.hasRow()) {
+        throw SQL::Exception("No row to read, executeStep() returned false.");
+    }
+
+    sqlite3_stmt* row = query.getPreparedStatement();
+    [&]<typename... Fs>(std::type_identity<std::tuple<Fs...>>) {
+        int index = 0;
+        (ColumnCodec<typename Fs::type>::read(row, index++, object.*Fs::member),
+         ...);
+    }(std::type_identity<Fields<T>>{});
+}
+}  // namespace detail
+
+// Decodes the current row of a select_sql<T> query.
+template <typename T>
+[[nodiscard]] T read_row(const SQL::Statement& query) {
+    T object = Schema<T>::blank();
+    detail::read_fields(query, object);
+
+    return object;
+}
+
+// Same, allocating the row's strings with alloc.
+template <typename T>
+[[nodiscard]] T read_row(const SQL::Statement& query,
+                         const typename T::allocator_type& alloc) {
+    T object = Schema<T>::blank(alloc);
+    detail::read_fields(query, object);
+
+    return object;
+}
+}  // namespace twodocore
@@ -4,7 +4,13 @@
 
 #include <filesystem>
 #include <optional>
+#include <utility>
 
+#include <2DOCore/cache.hpp>
+#include <2DOCore/cursor.hpp>
+#include <2DOCore/database.hpp>
+#include <2DOCore/notifier.hpp>
+#include <2DOCore/schema.hpp>
 #include <Utils/result.hpp>
 #include <Utils/type.hpp>
 #include <Utils/util.hpp>
@@ -13,24 +19,49 @@ namespace tdu = twodoutils;
 namespace SQL = SQLite;
 
 namespace twodocore {
+// Allocator-aware: the strings live in the memory resource the task was
+// built with, so a PmrVector<Task> keeps every task inside one arena.
 class [[nodiscard]] Task {
   public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
     Task(const Task&) = default;
     Task& operator=(const Task&) = default;
     Task(Task&& other) = default;
     Task& operator=(Task&& other) = default;
 
+    Task(const Task& other, const allocator_type& alloc)
+        : m_id{other.m_id},
+          m_topic{other.m_topic, alloc},
+          m_content{other.m_content, alloc},
+          m_start_date{other.m_start_date},
+          m_deadline{other.m_deadline},
+          m_executor_id{other.m_executor_id},
+          m_owner_id{other.m_owner_id},
+          m_is_done{other.m_is_done} {}
+
+    Task(Task&& other, const allocator_type& alloc)
+        : m_id{other.m_id},
+          m_topic{std::move(other.m_topic), alloc},
+          m_content{std::move(other.m_content), alloc},
+          m_start_date{other.m_start_date},
+          m_deadline{other.m_deadline},
+          m_executor_id{other.m_executor_id},
+          m_owner_id{other.m_owner_id},
+          m_is_done{other.m_is_done} {}
+
     Task(unsigned int id,
-         const String& topic,
-         const String& content,
+         StringView topic,
+         StringView content,
          const TimePoint& start_date,
          const TimePoint& deadline,
          const unsigned int executor_id,
          const unsigned int owner_id,
-         const bool is_done)
+         const bool is_done,
+         const allocator_type& alloc = {})
         : m_id{id},
-          m_topic{topic},
-          m_content{content},
+          m_topic{topic, alloc},
+          m_content{content, alloc},
           m_start_date{start_date},
           m_deadline{deadline},
           m_executor_id{executor_id},
@@ -38,8 +69,8 @@ class [[nodiscard]] Task {
           m_is_done{is_done} {}
 
     Task(unsigned int id,
-         const String& topic,
-         const String& content,
+         StringView topic,
+         StringView content,
          const String& start_date,
          const String& deadline,
          const unsigned int executor_id,
@@ -54,15 +85,16 @@ class [[nodiscard]] Task {
           m_owner_id{owner_id},
           m_is_done{static_cast<bool>(is_done)} {}
 
-    Task(const String& topic,
-         const String& content,
+    Task(StringView topic,
+         StringView content,
          const TimePoint& start_date,
          const TimePoint& deadline,
          const unsigned int executor_id,
          const unsigned int owner_id,
-         const bool is_done)
-        : m_topic{topic},
-          m_content{content},
+         const bool is_done,
+         const allocator_type& alloc = {})
+        : m_topic{topic, alloc},
+          m_content{content, alloc},
           m_start_date{start_date},
           m_deadline{deadline},
           m_executor_id{executor_id},
@@ -79,8 +111,8 @@ class [[nodiscard]] Task {
     }
 
     [[nodiscard]] unsigned int id() const { return m_id; }
-    [[nodiscard]] String topic() const { return m_topic; }
-    [[nodiscard]] String content() const { return m_content; }
+    [[nodiscard]] StringView topic() const { return m_topic; }
+    [[nodiscard]] StringView content() const { return m_content; }
     [[nodiscard]] unsigned int executor_id() const { return m_executor_id; }
     [[nodiscard]] unsigned int owner_id() const { return m_owner_id; }
     [[nodiscard]] bool is_done() const { return m_is_done; }
@@ -120,13 +152,108 @@ class [[nodiscard]] Task {
 
   private:
     unsigned int m_id{};
-    String m_topic{};
-    String m_content{};
+    PmrString m_topic{};
+    PmrString m_content{};
     TimePoint m_start_date{};
     TimePoint m_deadline{};
     unsigned int m_executor_id{};
     unsigned int m_owner_id{};
     bool m_is_done = false;
+
+    explicit Task(const allocator_type& alloc = {})
+        : m_topic{alloc}, m_content{alloc} {}
+
+    friend struct Schema<Task>;
+};
+
+template <>
+struct Schema<Task> {
+    static constexpr StringView table = "tasks";
+    using Fields = std::tuple<Field<"task_id", &Task::m_id>,
+                              Field<"topic", &Task::m_topic>,
+                              Field<"content", &Task::m_content>,
+                              Field<"start_date", &Task::m_start_date>,
+                              Field<"deadline", &Task::m_deadline>,
+                              Field<"executor_id", &Task::m_executor_id>,
+                              Field<"owner_id", &Task::m_owner_id>,
+                              Field<"is_done", &Task::m_is_done>>;
+
+    static Task blank(const Task::allocator_type& alloc = {}) {
+        return Task{alloc};
+    }
+};
+
+// The columns a task list needs; content and start date stay in the database
+// until the task itself is opened.
+class [[nodiscard]] TaskSummary {
+  public:
+    TaskSummary(const TaskSummary&) = default;
+    TaskSummary& operator=(const TaskSummary&) = default;
+    TaskSummary(TaskSummary&& other) = default;
+    TaskSummary& operator=(TaskSummary&& other) = default;
+
+    TaskSummary(unsigned int id,
+                String topic,
+                const TimePoint& deadline,
+                const unsigned int owner_id,
+                const bool is_done)
+        : m_id{id},
+          m_topic{std::move(topic)},
+          m_deadline{deadline},
+          m_owner_id{owner_id},
+          m_is_done{is_done} {}
+
+    bool operator==(const TaskSummary& other) const = default;
+
+    [[nodiscard]] unsigned int id() const { return m_id; }
+    [[nodiscard]] StringView topic() const { return m_topic; }
+    [[nodiscard]] TimePoint deadline() const { return m_deadline; }
+    [[nodiscard]] unsigned int owner_id() const { return m_owner_id; }
+    [[nodiscard]] bool is_done() const { return m_is_done; }
+
+  private:
+    unsigned int m_id{};
+    String m_topic{};
+    TimePoint m_deadline{};
+    unsigned int m_owner_id{};
+    bool m_is_done = false;
+
+    TaskSummary() = default;
+
+    friend struct Schema<TaskSummary>;
+};
+
+template <>
+struct Schema<TaskSummary> {
+    static constexpr StringView table = "tasks";
+    using Fields = std::tuple<Field<"task_id", &TaskSummary::m_id>,
+                              Field<"topic", &TaskSummary::m_topic>,
+                              Field<"deadline", &TaskSummary::m_deadline>,
+                              Field<"owner_id", &TaskSummary::m_owner_id>,
+                              Field<"is_done", &TaskSummary::m_is_done>>;
+
+    static TaskSummary blank() { return TaskSummary{}; }
+};
+
+// A task matching a search, with the best matching fragment of its topic,
+// content or discussion. Matched terms are wrapped in [brackets].
+struct [[nodiscard]] SearchHit {
+    unsigned int task_id;
+    String topic;
+    String snippet;
+    unsigned int owner_id;
+    unsigned int executor_id;
+};
+
+// Task counts for one user as executor. overdue and due_soon count open
+// tasks only, so neither overlaps done.
+struct [[nodiscard]] WorkloadStats {
+    unsigned int user_id;
+    String username;
+    unsigned int open;
+    unsigned int done;
+    unsigned int overdue;
+    unsigned int due_soon;
 };
 
 class [[nodiscard]] TaskDb {
@@ -138,76 +265,201 @@ class [[nodiscard]] TaskDb {
     TaskDb(TaskDb&& other) = default;
     TaskDb& operator=(TaskDb&& other) = default;
 
-    TaskDb(const fs::path& db_filepath);
+    explicit TaskDb(std::shared_ptr<Connection> connection);
 
+    // Served from the identity map when cached. Updates write through and
+    // deletes evict; inserts are cached on first read, so bulk loads do not
+    // fill memory.
     [[nodiscard]] Task get_object(const unsigned int id) const;
 
+    [[nodiscard]] CacheStats cache_stats() const { return m_cache->stats(); }
+
+    // Full-text search over the topics, contents and messages of the tasks
+    // the user owns or executes, one hit per task, best first. Every word of
+    // query must match; the last one may match as a prefix.
+    [[nodiscard]] Vector<SearchHit> search(StringView query,
+                                           const unsigned int user_id,
+                                           const unsigned int limit) const;
+
+    // One row per user, users without tasks included, counted in a single
+    // grouped query over the workload index; no task is read into memory.
+    // due_soon covers deadlines from now until due_within later.
+    [[nodiscard]] Vector<WorkloadStats> workload_stats(
+        const TimePoint now,
+        const sch::days due_within) const;
+
     [[nodiscard]] bool is_table_empty() const;
 
-    void add_object(Task& task) const;
-    void add_object(const Task& task) const;
+    unsigned int add_object(Task& task) const;
+    unsigned int add_object(const Task& task) const;
+
+    template <RangeOf<Task> R>
+    Vector<unsigned int> add_objects(R&& tasks) const {
+        Vector<unsigned int> ids;
+        if constexpr (std::ranges::sized_range<R>) {
+            ids.reserve(std::ranges::size(tasks));
+        }
+
+        UnitOfWork work{*m_connection};
+        for (auto&& task : tasks) {
+            ids.push_back(add_object(task));
+        }
+        work.commit();
+
+        return ids;
+    }
 
     void update_object(const Task& task) const;
 
+    template <RangeOf<Task> R>
+    void update_objects(const R& tasks) const {
+        UnitOfWork work{*m_connection};
+        for (const auto& task : tasks) {
+            update_object(task);
+        }
+        work.commit();
+    }
+
     void delete_object(const unsigned int id) const;
 
     template <IdType T>
     [[nodiscard]] Vector<Task> get_all_objects(const unsigned int id) const {
-        SQL::Statement query{m_db, ""};
-
-        if constexpr (T == IdType::Executor) {
-            query = SQL::Statement{m_db,
-                                   "SELECT * FROM tasks WHERE executor_id = ?"};
-        } else {
-            query =
-                SQL::Statement{m_db, "SELECT * FROM tasks WHERE owner_id = ?"};
+        auto query = select_all_objects<T>(id);
+
+        Vector<Task> tasks;
+        while (query->executeStep()) {
+            tasks.push_back(read_row<Task>(*query));
         }
 
-        query.bind(1, id);
+        return tasks;
+    }
 
-        Vector<Task> tasks;
-        while (query.executeStep()) {
-            tasks.push_back(Task{
-                (unsigned)query.getColumn(0).getInt(),
-                query.getColumn(1).getString(), query.getColumn(2).getString(),
-                query.getColumn(3).getString(), query.getColumn(4).getString(),
-                (unsigned)query.getColumn(5).getInt(),
-                (unsigned)query.getColumn(6).getInt(),
-                (unsigned)query.getColumn(7).getInt()});
+    // Builds the vector and every task's strings in resource, typically a
+    // monotonic arena released as a whole once the page is done with them.
+    template <IdType T>
+    [[nodiscard]] PmrVector<Task> get_all_objects(
+        const unsigned int id,
+        std::pmr::memory_resource* resource) const {
+        auto query = select_all_objects<T>(id);
+
+        PmrVector<Task> tasks{resource};
+        while (query->executeStep()) {
+            tasks.push_back(read_row<Task>(*query, tasks.get_allocator()));
         }
 
         return tasks;
     }
 
+    // Steps through the tasks in id order without materializing them all.
+    // Pass the last seen id as after_id to fetch the next page of limit rows;
+    // a negative limit means no limit.
+    template <IdType T>
+    [[nodiscard]] Cursor<Task> stream_all_objects(
+        const unsigned int id,
+        const unsigned int after_id = 0,
+        const int limit = -1) const {
+        m_connection->await_own_writes();
+        auto query = std::make_unique<SQL::Statement>(
+            m_connection->db(),
+            (T == IdType::Executor)
+                ? select_sql<Task, " WHERE executor_id = ? AND task_id > ? "
+                                   "ORDER BY task_id LIMIT ?">()
+                : select_sql<Task, " WHERE owner_id = ? AND task_id > ? "
+                                   "ORDER BY task_id LIMIT ?">());
+        query->bind(1, id);
+        query->bind(2, after_id);
+        query->bind(3, limit);
+
+        return Cursor<Task>{std::move(query), &read_row<Task>};
+    }
+
+    // Same paging as stream_all_objects, reading only the summary columns.
+    template <IdType T>
+    [[nodiscard]] Cursor<TaskSummary> stream_all_summaries(
+        const unsigned int id,
+        const unsigned int after_id = 0,
+        const int limit = -1) const {
+        m_connection->await_own_writes();
+        auto query = std::make_unique<SQL::Statement>(
+            m_connection->db(),
+            (T == IdType::Executor)
+                ? select_sql<TaskSummary,
+                             " WHERE executor_id = ? AND task_id > ? "
+                             "ORDER BY task_id LIMIT ?">()
+                : select_sql<TaskSummary,
+                             " WHERE owner_id = ? AND task_id > ? "
+                             "ORDER BY task_id LIMIT ?">());
+        query->bind(1, id);
+        query->bind(2, after_id);
+        query->bind(3, limit);
+
+        return Cursor<TaskSummary>{std::move(query), &read_row<TaskSummary>};
+    }
+
   private:
-    SQL::Database m_db;
+    std::shared_ptr<Connection> m_connection;
+    std::unique_ptr<StatementCache> m_statements;
+    std::unique_ptr<IdentityMap<Task>> m_cache;
+    ChangeSubscription m_subscription;
+
+    template <IdType T>
+    [[nodiscard]] CachedStatement select_all_objects(
+        const unsigned int id) const {
+        m_connection->await_own_writes();
+        auto query = m_statements->acquire(
+            (T == IdType::Executor)
+                ? select_sql<Task, " WHERE executor_id = ?">()
+                : select_sql<Task, " WHERE owner_id = ?">());
+        query->bind(1, id);
+
+        return query;
+    }
 };
 
+// Allocator-aware like Task.
 class [[nodiscard]] Message {
   public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
     Message(const Message&) = default;
     Message& operator=(const Message&) = default;
     Message(Message&& other) = default;
     Message& operator=(Message&& other) = default;
 
+    Message(const Message& other, const allocator_type& alloc)
+        : m_message_id{other.m_message_id},
+          m_task_id{other.m_task_id},
+          m_sender_name{other.m_sender_name, alloc},
+          m_content{other.m_content, alloc},
+          m_timestamp{other.m_timestamp} {}
+
+    Message(Message&& other, const allocator_type& alloc)
+        : m_message_id{other.m_message_id},
+          m_task_id{other.m_task_id},
+          m_sender_name{std::move(other.m_sender_name), alloc},
+          m_content{std::move(other.m_content), alloc},
+          m_timestamp{other.m_timestamp} {}
+
     Message(const unsigned int message_id,
             const unsigned int task_id,
             StringView sender_name,
             StringView content,
-            const TimePoint timestamp)
+            const TimePoint timestamp,
+            const allocator_type& alloc = {})
         : m_message_id{message_id},
           m_task_id{task_id},
-          m_sender_name{sender_name},
-          m_content{content},
+          m_sender_name{sender_name, alloc},
+          m_content{content, alloc},
           m_timestamp{timestamp} {}
 
     Message(const unsigned int task_id,
             StringView sender_name,
             StringView content,
-            const TimePoint timestamp)
+            const TimePoint timestamp,
+            const allocator_type& alloc = {})
         : m_task_id{task_id},
-          m_sender_name{sender_name},
-          m_content{content},
+          m_sender_name{sender_name, alloc},
+          m_content{content, alloc},
           m_timestamp{timestamp} {}
 
     Message(const unsigned int task_id,
@@ -228,8 +480,8 @@ class [[nodiscard]] Message {
 
     [[nodiscard]] int message_id() const { return m_message_id; }
     [[nodiscard]] int task_id() const { return m_task_id; }
-    [[nodiscard]] String sender_name() const { return m_sender_name; }
-    [[nodiscard]] String content() const { return m_content; }
+    [[nodiscard]] StringView sender_name() const { return m_sender_name; }
+    [[nodiscard]] StringView content() const { return m_content; }
 
     template <typename T>
     [[nodiscard]] typename std::enable_if<std::is_same<T, String>::value ||
@@ -246,11 +498,30 @@ class [[nodiscard]] Message {
     void set_message_id(const unsigned int id) { m_message_id = id; }
 
   private:
-    unsigned int m_message_id;
-    unsigned int m_task_id;
-    String m_sender_name;
-    String m_content;
-    TimePoint m_timestamp;
+    unsigned int m_message_id{};
+    unsigned int m_task_id{};
+    PmrString m_sender_name{};
+    PmrString m_content{};
+    TimePoint m_timestamp{};
+
+    explicit Message(const allocator_type& alloc = {})
+        : m_sender_name{alloc}, m_content{alloc} {}
+
+    friend struct Schema<Message>;
+};
+
+template <>
+struct Schema<Message> {
+    static constexpr StringView table = "messages";
+    using Fields = std::tuple<Field<"message_id", &Message::m_message_id>,
+                              Field<"task_id", &Message::m_task_id>,
+                              Field<"sender_name", &Message::m_sender_name>,
+                              Field<"content", &Message::m_content>,
+                              Field<"timestamp", &Message::m_timestamp>>;
+
+    static Message blank(const Message::allocator_type& alloc = {}) {
+        return Message{alloc};
+    }
 };
 
 class [[nodiscard]] MessageDb {
@@ -260,21 +531,61 @@ class [[nodiscard]] MessageDb {
     MessageDb(MessageDb&& other) = default;
     MessageDb& operator=(MessageDb&& other) = default;
 
-    MessageDb(const fs::path& db_filepath);
+    explicit MessageDb(std::shared_ptr<Connection> connection);
 
     [[nodiscard]] std::optional<Message> get_newest_object() const;
+    [[nodiscard]] std::optional<unsigned int> get_newest_id(
+        const unsigned int task_id) const;
+
+    // Messages of one task with ids above last_id, oldest first; a negative
+    // limit means no limit. Lets a view append only what it has not shown.
+    [[nodiscard]] Vector<Message> get_messages_since(
+        const unsigned int task_id,
+        const unsigned int last_id,
+        const int limit = -1) const;
+    // The newest n messages of one task, oldest first.
+    [[nodiscard]] Vector<Message> get_last_n(const unsigned int task_id,
+                                             const unsigned int n) const;
 
     [[nodiscard]] Vector<Message> get_all_objects(
         const unsigned int task_id) const;
+    // See TaskDb::get_all_objects.
+    [[nodiscard]] PmrVector<Message> get_all_objects(
+        const unsigned int task_id,
+        std::pmr::memory_resource* resource) const;
 
     [[nodiscard]] bool is_table_empty() const;
 
-    void add_object(Message& message) const;
-    void add_object(const Message& message) const;
+    unsigned int add_object(Message& message) const;
+    unsigned int add_object(const Message& message) const;
+
+    template <RangeOf<Message> R>
+    Vector<unsigned int> add_objects(R&& messages) const {
+        Vector<unsigned int> ids;
+        if constexpr (std::ranges::sized_range<R>) {
+            ids.reserve(std::ranges::size(messages));
+        }
+
+        UnitOfWork work{*m_connection};
+        for (auto&& message : messages) {
+            ids.push_back(add_object(message));
+        }
+        work.commit();
+
+        return ids;
+    }
 
     void delete_all_by_task_id(const unsigned int task_id) const;
 
+    // Bumped on every change to the messages table; pass the last version
+    // seen to wait_for_change to block until there is something new.
+    [[nodiscard]] std::uint64_t change_version() const;
+    std::uint64_t wait_for_change(const std::uint64_t seen,
+                                  std::stop_token stop) const;
+
   private:
-    SQL::Database m_db;
+    std::shared_ptr<Connection> m_connection;
+    std::unique_ptr<StatementCache> m_statements;
+    std::unique_ptr<ChangeNotifier> m_changes;
 };
 }  // namespace twodocore
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+
+#include <2DOCore/database.hpp>
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace twodocore {
+enum class TransferFormat { Csv, Jsonl };
+
+// Tables that can be exported and imported.
+inline constexpr Array<StringView, 3> TRANSFER_TABLES = {"users", "tasks",
+                                                         "messages"};
+
+inline constexpr std::size_t TRANSFER_BUFFER_SIZE = 64 * 1024;
+inline constexpr std::size_t IMPORT_BATCH_SIZE = 10'000;
+
+// Picks the format from a .csv or .jsonl extension.
+[[nodiscard]] std::optional<TransferFormat> transfer_format_of(
+    const fs::path& path);
+
+struct [[nodiscard]] TransferStats {
+    std::size_t rows;
+    NanoSeconds elapsed;
+
+    [[nodiscard]] double rows_per_second() const;
+};
+
+// Writes every row of table, keys included, in rowid order. CSV gets a
+// header line, NULL as an empty field and empty text as ""; JSONL gets one
+// object per line with the column names as keys. Rows go out through a
+// TRANSFER_BUFFER_SIZE buffer.
+TransferStats export_table(Connection& connection,
+                           StringView table,
+                           const TransferFormat format,
+                           const fs::path& path);
+
+// Inserts the rows of a file written by export_table, committing every
+// batch_size rows. The file is memory-mapped and fields are bound straight
+// from the mapping; only fields with escapes are copied, into buffers reused
+// from row to row. Throws std::runtime_error on malformed input or on a
+// column the table does not have.
+TransferStats import_table(Connection& connection,
+                           StringView table,
+                           const TransferFormat format,
+                           const fs::path& path,
+                           const std::size_t batch_size = IMPORT_BATCH_SIZE);
+}  // namespace twodocore
@@ -2,9 +2,14 @@
 
 #include <filesystem>
 #include <optional>
+#include <utility>
 
 #include <SQLiteCpp/Database.h>
 
+#include <2DOCore/cache.hpp>
+#include <2DOCore/cursor.hpp>
+#include <2DOCore/database.hpp>
+#include <2DOCore/schema.hpp>
 #include <Utils/result.hpp>
 #include <Utils/type.hpp>
 #include <Utils/util.hpp>
@@ -15,6 +20,13 @@ namespace SQL = SQLite;
 namespace twodocore {
 enum class Role { User, Admin };
 
+// Roles are stored by name.
+template <>
+struct ColumnCodec<Role> {
+    static void bind(SQL::Statement& query, int index, Role value);
+    static void read(sqlite3_stmt* row, int index, Role& value);
+};
+
 class [[nodiscard]] User {
   public:
     User(const User&) = default;
@@ -23,25 +35,27 @@ class [[nodiscard]] User {
     User& operator=(User&& other) = default;
 
     User(const unsigned int user_id,
-         StringView username,
+         String username,
          const Role role,
          const String& password)
         : m_user_id{user_id},
-          m_username{username},
+          m_username{std::move(username)},
           m_role{role},
           m_password{tdu::hash(password)} {}
 
     User(const unsigned int user_id,
-         StringView username,
+         String username,
          const String& role,
-         const String& password)
+         String password)
         : m_user_id{user_id},
-          m_username{username},
+          m_username{std::move(username)},
           m_role{stor(role)},
-          m_password{password} {}
+          m_password{std::move(password)} {}
 
-    User(StringView username, const Role role, const String& password)
-        : m_username{username}, m_role{role}, m_password{tdu::hash(password)} {}
+    User(String username, const Role role, const String& password)
+        : m_username{std::move(username)},
+          m_role{role},
+          m_password{tdu::hash(password)} {}
 
     bool operator==(const User& other) const {
         return m_user_id == other.m_user_id && m_username == other.m_username &&
@@ -49,8 +63,8 @@ class [[nodiscard]] User {
     }
 
     [[nodiscard]] unsigned int id() const { return m_user_id; }
-    [[nodiscard]] String username() const { return m_username; }
-    [[nodiscard]] String password() const { return m_password; }
+    [[nodiscard]] StringView username() const { return m_username; }
+    [[nodiscard]] StringView password() const { return m_password; }
 
     template <typename T>
     [[nodiscard]] typename std::enable_if<std::is_same<T, String>::value ||
@@ -65,7 +79,7 @@ class [[nodiscard]] User {
     }
 
     void set_id(const unsigned int user_id) { m_user_id = user_id; }
-    void set_username(StringView username) { m_username = username; }
+    void set_username(String username) { m_username = std::move(username); }
     void set_role(const Role role) { m_role = role; }
     void set_password(const String& passwd) { m_password = tdu::hash(passwd); }
 
@@ -77,6 +91,21 @@ class [[nodiscard]] User {
 
     [[nodiscard]] Role stor(const String& role_str) const;
     [[nodiscard]] String rtos(const Role role) const;
+
+    User() = default;
+
+    friend struct Schema<User>;
+};
+
+template <>
+struct Schema<User> {
+    static constexpr StringView table = "users";
+    using Fields = std::tuple<Field<"user_id", &User::m_user_id>,
+                              Field<"username", &User::m_username>,
+                              Field<"role", &User::m_role>,
+                              Field<"password", &User::m_password>>;
+
+    static User blank() { return User{}; }
 };
 
 class [[nodiscard]] UserDb {
@@ -86,26 +115,57 @@ class [[nodiscard]] UserDb {
     UserDb(UserDb&& other) = default;
     UserDb& operator=(UserDb&& other) = default;
 
-    UserDb(const fs::path& db_filepath);
+    explicit UserDb(std::shared_ptr<Connection> connection);
 
+    // get_object and get_all_objects are served from the identity map when
+    // cached; see TaskDb::get_object.
     [[nodiscard]] User get_object(const unsigned int id) const;
 
     [[nodiscard]] std::optional<User> find_object_by_unique_column(
-        const String& column_value) const;
+        StringView column_value) const;
 
     [[nodiscard]] Vector<User> get_all_objects() const;
+    // Only the vector lives in resource; users keep their own strings.
+    [[nodiscard]] PmrVector<User> get_all_objects(
+        std::pmr::memory_resource* resource) const;
+
+    // Steps through the users in id order; see TaskDb::stream_all_objects.
+    [[nodiscard]] Cursor<User> stream_all_objects(
+        const unsigned int after_id = 0,
+        const int limit = -1) const;
 
     [[nodiscard]] bool is_table_empty() const;
 
-    void add_object(User& user);
-    void add_object(const User& user) const;
+    unsigned int add_object(User& user) const;
+    unsigned int add_object(const User& user) const;
+
+    template <RangeOf<User> R>
+    Vector<unsigned int> add_objects(R&& users) const {
+        Vector<unsigned int> ids;
+        if constexpr (std::ranges::sized_range<R>) {
+            ids.reserve(std::ranges::size(users));
+        }
+
+        UnitOfWork work{*m_connection};
+        for (auto&& user : users) {
+            ids.push_back(add_object(user));
+        }
+        work.commit();
+
+        return ids;
+    }
 
     void update_object(const User& user) const;
 
     void delete_object(const unsigned int id) const;
 
+    [[nodiscard]] CacheStats cache_stats() const { return m_cache->stats(); }
+
   private:
-    SQL::Database m_db;
+    std::shared_ptr<Connection> m_connection;
+    std::unique_ptr<StatementCache> m_statements;
+    std::unique_ptr<IdentityMap<User>> m_cache;
+    ChangeSubscription m_subscription;
 };
 
 enum class AuthErr {
@@ -139,7 +199,4 @@ class [[nodiscard]] AuthenticationManager {
 
     [[nodiscard]] bool is_in_db(const String& username) const;
 };
-
-void clear_all_db_data(const fs::path& filepath,
-                    const Vector<String>& table_names);
 }  // namespace twodocore
\ No newline at end of file
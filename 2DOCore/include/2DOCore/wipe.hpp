@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include <2DOCore/database.hpp>
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace twodocore {
+struct [[nodiscard]] WipeProgress {
+    String step;
+    std::size_t done;
+    std::size_t total;
+};
+
+using WipeProgressListener = std::function<void(const WipeProgress&)>;
+
+struct [[nodiscard]] WipeStats {
+    std::int64_t bytes_before;
+    std::int64_t bytes_after;
+    NanoSeconds elapsed;
+};
+
+// Empties every table in table_names in one transaction. Each table is
+// dropped and created again from its own schema, indexes and triggers
+// included, so the cost does not grow with the row count the way a DELETE
+// firing the full-text triggers row by row does; the full-text indexes
+// over the tables are emptied whole and AUTOINCREMENT counters start over.
+// The freed pages are then given back with VACUUM, which is skipped when
+// another statement on the connection is still running.
+//
+// listener, when given, hears of each step before it starts and once more
+// when everything is done.
+WipeStats clear_all_db_data(Connection& connection,
+                            const Vector<String>& table_names,
+                            const WipeProgressListener& listener = {});
+}  // namespace twodocore
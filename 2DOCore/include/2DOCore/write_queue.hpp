@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <thread>
+
+#include <2DOCore/database.hpp>
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace twodocore {
+inline constexpr std::size_t WRITE_QUEUE_CAPACITY = 1024;
+
+// Bounded multi-producer multi-consumer ring after Dmitry Vyukov. Every
+// cell carries a sequence number saying whose turn it is, so a push or pop
+// is one compare-and-swap on its index and never takes a lock. Values come
+// out in the order their push claimed a position.
+template <typename T>
+class [[nodiscard]] BoundedQueue {
+  public:
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // capacity must be a power of two.
+    explicit BoundedQueue(const std::size_t capacity)
+        : m_mask{capacity - 1}, m_cells{std::make_unique<Cell[]>(capacity)} {
+        for (std::size_t i = 0; i < capacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    [[nodiscard]] std::size_t capacity() const { return m_mask + 1; }
+
+    // Returns the position the value took, or nullopt when full.
+    std::optional<std::size_t> try_push(T&& value) {
+        std::size_t position = m_tail.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = m_cells[position & m_mask];
+            const std::size_t sequence =
+                cell.sequence.load(std::memory_order_acquire);
+            const auto lag = static_cast<std::ptrdiff_t>(sequence - position);
+
+            if (lag == 0) {
+                if (m_tail.compare_exchange_weak(position, position + 1,
+                                                 std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1,
+                                        std::memory_order_release);
+                    return position;
+                }
+            } else if (lag < 0) {
+                return std::nullopt;
+            } else {
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::optional<T> try_pop() {
+        std::size_t position = m_head.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = m_cells[position & m_mask];
+            const std::size_t sequence =
+                cell.sequence.load(std::memory_order_acquire);
+            const auto lag =
+                static_cast<std::ptrdiff_t>(sequence - (position + 1));
+
+            if (lag == 0) {
+                if (m_head.compare_exchange_weak(position, position + 1,
+                                                 std::memory_order_relaxed)) {
+                    T value = std::move(cell.value);
+                    cell.sequence.store(position + m_mask + 1,
+                                        std::memory_order_release);
+                    return value;
+                }
+            } else if (lag < 0) {
+                return std::nullopt;
+            } else {
+                position = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+  private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    // Producers and the consumer spin on different lines.
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    const std::size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    alignas(CACHE_LINE) std::atomic<std::size_t> m_tail{0};
+    alignas(CACHE_LINE) std::atomic<std::size_t> m_head{0};
+};
+
+// Completion of one queued write. Dropping it does not cancel the write.
+class WriteTicket {
+  public:
+    explicit WriteTicket(std::shared_future<void> committed)
+        : m_committed{std::move(committed)} {}
+
+    // Blocks until the write is committed to disk, and rethrows what it
+    // threw if it failed.
+    void wait() const { m_committed.get(); }
+
+    [[nodiscard]] bool is_done() const {
+        return m_committed.wait_for(sch::seconds{0}) ==
+               std::future_status::ready;
+    }
+
+  private:
+    std::shared_future<void> m_committed;
+};
+
+// Called on the writer thread with each write that failed.
+using WriteErrorListener = std::function<void(std::exception_ptr error)>;
+
+struct [[nodiscard]] WriteQueueStats {
+    std::uint64_t writes;
+    std::uint64_t commits;
+};
+
+// Runs writes on a thread of its own so the caller never waits for the
+// disk. Whatever has queued up while the last commit was in flight goes
+// into the next transaction, so a burst of writes shares one fsync; each
+// write still gets a savepoint of its own, so a failing one is rolled back
+// alone.
+//
+// A thread reading through the connection's repositories, or through a
+// reader following it, first waits for the writes it queued itself to be
+// committed, so it always sees its own changes. A group holds the
+// connection's lock until it commits, so other threads using the
+// connection wait for it and never see it half done.
+class [[nodiscard]] WriteQueue {
+  public:
+    WriteQueue(const WriteQueue&) = delete;
+    WriteQueue& operator=(const WriteQueue&) = delete;
+
+    // One queue per connection.
+    explicit WriteQueue(std::shared_ptr<Connection> connection,
+                        WriteErrorListener on_error = {},
+                        const std::size_t capacity = WRITE_QUEUE_CAPACITY);
+
+    // Applies and commits everything still queued first.
+    ~WriteQueue();
+
+    // Queues write to run on the writer thread inside a transaction.
+    // Blocks only while the queue is full, until the writer makes room.
+    WriteTicket submit(std::function<void()> write);
+
+    // Completes once everything queued so far is committed.
+    WriteTicket flush();
+
+    // Blocks until the writes this thread queued have been committed, or
+    // have failed.
+    void sync() const;
+
+    [[nodiscard]] WriteQueueStats stats() const;
+
+  private:
+    struct PendingWrite {
+        std::function<void()> write;
+        std::promise<void> committed;
+    };
+
+    std::shared_ptr<Connection> m_connection;
+    WriteErrorListener m_on_error;
+    // Tells this queue's entries apart in the per-thread bookkeeping.
+    const std::uint64_t m_id;
+
+    BoundedQueue<PendingWrite> m_queue;
+    // Bumped after every push, and to stop; the writer sleeps on it.
+    std::atomic<std::uint64_t> m_signal{0};
+    // Bumped whenever the writer takes writes off; a full submit sleeps on
+    // it.
+    std::atomic<std::uint64_t> m_taken{0};
+    // Writes taken off the queue and committed or failed, in queue order.
+    std::atomic<std::uint64_t> m_applied{0};
+    std::atomic<std::uint64_t> m_commits{0};
+
+    // Last, so it is joined before anything it uses goes away.
+    std::jthread m_thread{};
+
+    void run(std::stop_token stop);
+    void commit_group(Vector<PendingWrite>& group);
+};
+}  // namespace twodocore
@@ -0,0 +1,233 @@
+#include "2DOCore/archive.hpp"
+
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Statement.h>
+#include <sqlite3.h>
+
+#include <format>
+#include <utility>
+
+namespace twodocore {
+namespace {
+constexpr const char* ARCHIVE_SCHEMA =
+    "CREATE TABLE IF NOT EXISTS archive.tasks ("
+    "task_id INTEGER PRIMARY KEY NOT NULL, "
+    "topic VARCHAR(20) NOT NULL, "
+    "content TEXT NOT NULL, "
+    "start_date INTEGER NOT NULL, "
+    "deadline INTEGER NOT NULL, "
+    "executor_id INTEGER NOT NULL, "
+    "owner_id INTEGER NOT NULL, "
+    "is_done BOOLEAN NOT NULL, "
+    "done_at INTEGER, "
+    "archived_at INTEGER NOT NULL);"
+    "CREATE INDEX IF NOT EXISTS archive.tasks_executor_id_idx "
+    "ON tasks (executor_id);"
+    "CREATE INDEX IF NOT EXISTS archive.tasks_owner_id_idx "
+    "ON tasks (owner_id);"
+    "CREATE TABLE IF NOT EXISTS archive.messages ("
+    "message_id INTEGER PRIMARY KEY NOT NULL, "
+    "task_id INTEGER NOT NULL, "
+    "sender_name VARCHAR(20) NOT NULL, "
+    "content VARCHAR(200) NOT NULL, "
+    "timestamp INTEGER NOT NULL);"
+    "CREATE INDEX IF NOT EXISTS archive.messages_task_id_message_id_idx "
+    "ON messages (task_id, message_id);";
+
+// Replacing makes a move cut short by a crash safe to run again. An id
+// already in the archive is always the same row, as reserve_archived_ids
+// keeps new rows from taking one.
+constexpr const char* COPY_TASKS_SQL =
+    "INSERT OR REPLACE INTO archive.tasks SELECT task_id, topic, content, "
+    "start_date, deadline, executor_id, owner_id, is_done, done_at, ?2 "
+    "FROM main.tasks WHERE done_at <= ?1";
+
+constexpr const char* COPY_MESSAGES_SQL =
+    "INSERT OR REPLACE INTO archive.messages SELECT m.message_id, "
+    "m.task_id, m.sender_name, m.content, m.timestamp "
+    "FROM main.messages m JOIN main.tasks t ON t.task_id = m.task_id "
+    "WHERE t.done_at <= ?1";
+
+// Only rows already in the archive are deleted, whatever came in between.
+constexpr const char* DELETE_MESSAGES_SQL =
+    "DELETE FROM main.messages WHERE task_id IN "
+    "(SELECT task_id FROM main.tasks WHERE done_at <= ?1) "
+    "AND EXISTS (SELECT 1 FROM archive.messages a "
+    "WHERE a.message_id = messages.message_id)";
+
+constexpr const char* DELETE_TASKS_SQL =
+    "DELETE FROM main.tasks WHERE done_at <= ?1 "
+    "AND EXISTS (SELECT 1 FROM archive.tasks a "
+    "WHERE a.task_id = tasks.task_id)";
+
+// Raises the AUTOINCREMENT counters of the hot tables past the archived
+// ids, adding the counter row a table never written to does not have yet.
+constexpr const char* RESERVE_IDS_SQL =
+    "UPDATE main.sqlite_sequence SET seq = max(seq, "
+    "(SELECT IFNULL(MAX(task_id), 0) FROM archive.tasks)) "
+    "WHERE name = 'tasks';"
+    "INSERT INTO main.sqlite_sequence (name, seq) "
+    "SELECT 'tasks', MAX(task_id) FROM archive.tasks "
+    "HAVING MAX(task_id) IS NOT NULL AND NOT EXISTS "
+    "(SELECT 1 FROM main.sqlite_sequence WHERE name = 'tasks');"
+    "UPDATE main.sqlite_sequence SET seq = max(seq, "
+    "(SELECT IFNULL(MAX(message_id), 0) FROM archive.messages)) "
+    "WHERE name = 'messages';"
+    "INSERT INTO main.sqlite_sequence (name, seq) "
+    "SELECT 'messages', MAX(message_id) FROM archive.messages "
+    "HAVING MAX(message_id) IS NOT NULL AND NOT EXISTS "
+    "(SELECT 1 FROM main.sqlite_sequence WHERE name = 'messages');";
+
+// Same column order as Schema<Task> and Schema<Message>, for read_row.
+constexpr const char* SELECT_TASKS_SQL =
+    "SELECT task_id, topic, content, start_date, deadline, executor_id, "
+    "owner_id, is_done FROM archive.tasks "
+    "WHERE (owner_id = ?1 OR executor_id = ?1) AND task_id > ?2 "
+    "ORDER BY task_id LIMIT ?3";
+
+constexpr const char* SELECT_MESSAGES_SQL =
+    "SELECT message_id, task_id, sender_name, content, timestamp "
+    "FROM archive.messages WHERE task_id = ? ORDER BY message_id";
+
+// Runs sql with ?1 bound to cutoff and ?2, if used, to now. Returns the
+// number of rows changed.
+int run(SQL::Database& db,
+        const char* sql,
+        const TimePoint cutoff,
+        const TimePoint now = {}) {
+    SQL::Statement query{db, sql};
+    query.bind(1, tdu::to_epoch_minutes(cutoff));
+    if (sqlite3_bind_parameter_count(query.getPreparedStatement()) > 1) {
+        query.bind(2, tdu::to_epoch_minutes(now));
+    }
+
+    return query.exec();
+}
+
+void attach(SQL::Database& db, const fs::path& archive_path) {
+    SQL::Statement query{db, "ATTACH DATABASE ? AS archive"};
+    query.bind(1, archive_path.string());
+    query.exec();
+}
+
+void detach(Connection& connection) {
+    try {
+        connection.db().exec("DETACH DATABASE archive");
+    } catch (const SQL::Exception&) {
+        // Still in use by a running statement; it goes with the connection.
+    }
+}
+}  // namespace
+
+TaskArchive::TaskArchive(std::shared_ptr<Connection> connection,
+                         const fs::path& archive_path,
+                         const sch::days archive_after,
+                         std::shared_ptr<Connection> reader)
+    : m_connection{std::move(connection)},
+      m_reader{reader ? std::move(reader) : m_connection},
+      m_archive_after{archive_after} {
+    SQL::Database& db = m_connection->db();
+    attach(db, archive_path);
+
+    try {
+        const auto& profile = m_connection->profile();
+        db.exec(std::format(
+            "PRAGMA archive.journal_mode = {};"
+            "PRAGMA archive.synchronous = {};",
+            profile.journal_mode, profile.synchronous));
+
+        UnitOfWork work{*m_connection};
+        db.exec(ARCHIVE_SCHEMA);
+        db.exec(RESERVE_IDS_SQL);
+        work.commit();
+
+        // Only once the schema is there, as a reader cannot create it.
+        if (m_reader != m_connection) {
+            attach(m_reader->db(), archive_path);
+        }
+    } catch (...) {
+        db.exec("DETACH DATABASE archive");
+        throw;
+    }
+}
+
+TaskArchive::~TaskArchive() {
+    detach(*m_connection);
+    if (m_reader != m_connection) {
+        detach(*m_reader);
+    }
+}
+
+ArchiveStats TaskArchive::archive_done(const TimePoint now) const {
+    SQL::Database& db = m_connection->db();
+    const TimePoint cutoff = now - m_archive_after;
+    const auto start = sch::steady_clock::now();
+    // No other thread's transaction gets in between the two.
+    const auto lock = m_connection->lock();
+
+    // With WAL a transaction spanning both files is atomic in each file but
+    // not across them, so the copy is committed before anything is deleted.
+    {
+        UnitOfWork work{*m_connection};
+        run(db, COPY_TASKS_SQL, cutoff, now);
+        run(db, COPY_MESSAGES_SQL, cutoff);
+        work.commit();
+    }
+
+    UnitOfWork work{*m_connection};
+    const int messages = run(db, DELETE_MESSAGES_SQL, cutoff);
+    const int tasks = run(db, DELETE_TASKS_SQL, cutoff);
+    work.commit();
+
+    return {static_cast<unsigned int>(tasks),
+            static_cast<unsigned int>(messages),
+            sch::steady_clock::now() - start};
+}
+
+Cursor<Task> TaskArchive::stream_tasks(const unsigned int user_id,
+                                       const unsigned int after_id,
+                                       const int limit) const {
+    m_reader->await_own_writes();
+    auto query =
+        std::make_unique<SQL::Statement>(m_reader->db(), SELECT_TASKS_SQL);
+    query->bind(1, user_id);
+    query->bind(2, after_id);
+    query->bind(3, limit);
+
+    return Cursor<Task>{std::move(query), &read_row<Task>};
+}
+
+Vector<Message> TaskArchive::get_messages(const unsigned int task_id) const {
+    m_reader->await_own_writes();
+    SQL::Statement query{m_reader->db(), SELECT_MESSAGES_SQL};
+    query.bind(1, task_id);
+
+    Vector<Message> messages;
+    while (query.executeStep()) {
+        messages.push_back(read_row<Message>(query));
+    }
+
+    return messages;
+}
+
+unsigned int TaskArchive::task_count() const {
+    m_reader->await_own_writes();
+    SQL::Statement query{m_reader->db(), "SELECT COUNT(*) FROM archive.tasks"};
+    query.executeStep();
+
+    return static_cast<unsigned int>(query.getColumn(0).getInt64());
+}
+
+void TaskArchive::reserve_archived_ids() const {
+    UnitOfWork work{*m_connection};
+    m_connection->db().exec(RESERVE_IDS_SQL);
+    work.commit();
+}
+
+void TaskArchive::clear() const {
+    UnitOfWork work{*m_connection};
+    m_connection->db().exec(
+        "DELETE FROM archive.tasks; DELETE FROM archive.messages;");
+    work.commit();
+}
+}  // namespace twodocore
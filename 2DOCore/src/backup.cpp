@@ -0,0 +1,197 @@
+#include "2DOCore/backup.hpp"
+
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/Transaction.h>
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+namespace twodocore {
+OnlineBackup::OnlineBackup(Connection& source, const fs::path& path)
+    : m_source{source},
+      m_target{path, SQL::OPEN_READWRITE | SQL::OPEN_CREATE},
+      m_backup{m_target, source.db()} {
+    // The last step commits the copy while the source is locked; syncing is
+    // left until after, when it keeps no one waiting.
+    m_target.exec("PRAGMA synchronous = OFF");
+}
+
+bool OnlineBackup::step(const int pages) {
+    // BUSY and LOCKED only mean the source is being written to right now;
+    // the next step tries again.
+    const auto lock = m_source.lock();
+    return m_backup.executeStep(pages) == SQLITE_DONE;
+}
+
+SnapshotStore::SnapshotStore(std::shared_ptr<Connection> connection,
+                             fs::path folder,
+                             const std::size_t keep)
+    : m_connection{std::move(connection)},
+      m_folder{std::move(folder)},
+      m_keep{std::max<std::size_t>(keep, 1)} {}
+
+SnapshotStore::SnapshotStore(std::shared_ptr<ConnectionPool> pool,
+                             fs::path folder,
+                             const std::size_t keep)
+    : m_pool{std::move(pool)},
+      m_connection{m_pool->writer()},
+      m_folder{std::move(folder)},
+      m_keep{std::max<std::size_t>(keep, 1)} {}
+
+Vector<Snapshot> SnapshotStore::list() const {
+    Vector<Snapshot> snapshots;
+    for (const auto& entry : fs::directory_iterator{m_folder}) {
+        const auto& path = entry.path();
+        const String stem = path.stem().string();
+        if (entry.is_regular_file() &&
+            path.extension() == SNAPSHOT_EXTENSION &&
+            stem.starts_with(SNAPSHOT_PREFIX)) {
+            snapshots.push_back(
+                Snapshot{path, stem.substr(SNAPSHOT_PREFIX.size())});
+        }
+    }
+
+    std::ranges::sort(snapshots, std::ranges::greater{}, &Snapshot::name);
+
+    return snapshots;
+}
+
+std::size_t SnapshotStore::keep() const {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_keep;
+}
+
+void SnapshotStore::set_keep(const std::size_t keep) {
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_keep = std::max<std::size_t>(keep, 1);
+    }
+
+    std::lock_guard<std::mutex> job{m_job_mutex};
+    prune(this->keep());
+}
+
+std::optional<Snapshot> SnapshotStore::take(std::stop_token stop) {
+    std::lock_guard<std::mutex> job{m_job_mutex};
+
+    auto now = sch::floor<sch::milliseconds>(sch::system_clock::now());
+    fs::path path;
+    String name;
+    do {
+        name = std::format("{:%Y-%m-%d_%H-%M-%S}", now);
+        path = m_folder / (String{SNAPSHOT_PREFIX} + name +
+                           String{SNAPSHOT_EXTENSION});
+        now += sch::milliseconds{1};
+    } while (fs::exists(path));
+
+    std::optional<ReaderLease> reader;
+    std::optional<SQL::Transaction> read;
+    Connection* source = m_connection.get();
+    if (m_pool) {
+        reader.emplace(m_pool->acquire_reader());
+        source = reader->connection().get();
+
+        // The open read holds one snapshot for the whole copy. Under a
+        // rollback journal it would keep the writer from committing until
+        // the copy is done.
+        if (source->profile().journal_mode == "WAL") {
+            read.emplace(source->db());
+            SQL::Statement{source->db(), "SELECT 1 FROM sqlite_master LIMIT 1"}
+                .executeStep();
+        }
+    }
+
+    const fs::path partial = fs::path{path} += ".part";
+    bool done = false;
+    try {
+        OnlineBackup backup{*source, partial};
+
+        std::mutex pause_mutex;
+        std::condition_variable_any pause;
+        std::unique_lock<std::mutex> lock{pause_mutex};
+        while (!(done = backup.step()) && !stop.stop_requested()) {
+            // Nothing wakes this early but a stop request.
+            pause.wait_for(lock, stop, BACKUP_STEP_PAUSE,
+                           [] { return false; });
+        }
+    } catch (...) {
+        fs::remove(partial);
+        throw;
+    }
+
+    if (!done) {
+        fs::remove(partial);
+        return std::nullopt;
+    }
+
+    // The copy keeps the source's WAL mode; a rollback journal leaves the
+    // snapshot a single file once closed. Switching commits with a full
+    // sync, which also flushes the pages the backup wrote unsynced.
+    SQL::Database{partial, SQL::OPEN_READWRITE}.exec(
+        "PRAGMA journal_mode = DELETE");
+    fs::rename(partial, path);
+    prune(keep());
+
+    return Snapshot{path, name};
+}
+
+void SnapshotStore::restore(const Snapshot& snapshot) {
+    std::lock_guard<std::mutex> job{m_job_mutex};
+
+    {
+        const auto lock = m_connection->lock();
+        SQL::Database source{snapshot.path, SQL::OPEN_READWRITE};
+        SQL::Backup backup{m_connection->db(), source};
+
+        // All at once, so no reader ever sees half a restore.
+        if (backup.executeStep() != SQLITE_DONE) {
+            throw std::runtime_error(
+                "The database is busy, the snapshot was not restored.");
+        }
+    }
+
+    m_connection->notify_reset();
+}
+
+void SnapshotStore::start(const sch::minutes interval) {
+    m_thread = std::jthread{[this, interval](std::stop_token stop) {
+        while (!stop.stop_requested()) {
+            {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_wake.wait_for(lock, stop, interval,
+                                [&] { return m_requested; });
+                m_requested = false;
+            }
+            if (stop.stop_requested()) {
+                break;
+            }
+
+            // A failed snapshot is retried on the next wake-up.
+            try {
+                const auto snapshot = take(stop);
+            } catch (const SQL::Exception&) {
+            } catch (const fs::filesystem_error&) {
+            }
+        }
+    }};
+}
+
+void SnapshotStore::request() {
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_requested = true;
+    }
+    m_wake.notify_all();
+}
+
+void SnapshotStore::prune(const std::size_t keep) const {
+    const auto snapshots = list();
+    for (std::size_t i = keep; i < snapshots.size(); ++i) {
+        fs::remove(snapshots[i].path);
+    }
+}
+}  // namespace twodocore
@@ -0,0 +1,249 @@
+#include "2DOCore/database.hpp"
+
+#include "2DOCore/migration.hpp"
+#include "2DOCore/write_queue.hpp"
+
+#include <sqlite3.h>
+
+#include <format>
+
+namespace twodocore {
+CachedStatement StatementCache::acquire(StringView sql) {
+    auto connection_lock = m_connection.lock();
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    auto it = m_statements.find(sql);
+    if (it == m_statements.end()) {
+        String key{sql};
+        auto statement =
+            std::make_unique<SQL::Statement>(m_connection.db(), key);
+        it = m_statements.emplace(std::move(key), std::move(statement)).first;
+    } else {
+        it->second->reset();
+        it->second->clearBindings();
+    }
+
+    return CachedStatement{*it->second, std::move(connection_lock)};
+}
+
+std::size_t StatementCache::size() const {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_statements.size();
+}
+
+std::optional<ConnectionProfile> find_connection_profile(StringView name) {
+    for (const auto& profile : CONNECTION_PROFILES) {
+        if (profile.name == name) {
+            return profile;
+        }
+    }
+
+    return std::nullopt;
+}
+
+Connection::Connection(const fs::path& db_filepath,
+                       const ConnectionProfile& profile,
+                       const ConnectionRole role)
+    : m_db{db_filepath, role == ConnectionRole::Reader ? SQL::OPEN_READONLY
+                                                       : SQL::OPEN_READWRITE},
+      m_profile{profile},
+      m_role{role} {
+    apply_profile();
+    if (m_role == ConnectionRole::Writer) {
+        migrate(m_db);
+    }
+
+    sqlite3_update_hook(
+        m_db.getHandle(),
+        [](void* self, int operation, const char*, const char* table,
+           sqlite3_int64 rowid) {
+            static_cast<Connection*>(self)->notify(
+                operation == SQLITE_INSERT   ? Change::Insert
+                : operation == SQLITE_UPDATE ? Change::Update
+                                             : Change::Delete,
+                table, rowid);
+        },
+        this);
+    sqlite3_rollback_hook(
+        m_db.getHandle(),
+        [](void* self) {
+            static_cast<Connection*>(self)->notify_rollback(true);
+        },
+        this);
+
+    // SQLite has no hook after a commit, but a statement's profile callback
+    // runs once it has finished, commit included; outside a transaction by
+    // then, whatever it changed is readable from other connections.
+    if (m_role == ConnectionRole::Writer) {
+        sqlite3_trace_v2(
+            m_db.getHandle(), SQLITE_TRACE_PROFILE,
+            [](unsigned int, void* self, void*, void*) {
+                auto* connection = static_cast<Connection*>(self);
+                if (sqlite3_get_autocommit(connection->m_db.getHandle())) {
+                    connection->notify_committed();
+                }
+                return 0;
+            },
+            this);
+    }
+}
+
+Connection::~Connection() {
+    sqlite3_update_hook(m_db.getHandle(), nullptr, nullptr);
+    sqlite3_rollback_hook(m_db.getHandle(), nullptr, nullptr);
+    sqlite3_trace_v2(m_db.getHandle(), 0, nullptr, nullptr);
+}
+
+ChangeSubscription Connection::subscribe(ChangeListener listener) {
+    std::lock_guard<std::mutex> lock{m_listeners_mutex};
+
+    const unsigned int id = m_next_listener_id++;
+    m_listeners.emplace(id, std::move(listener));
+
+    return ChangeSubscription{*this, id};
+}
+
+ChangeSubscription Connection::subscribe_committed(ChangeListener listener) {
+    std::lock_guard<std::mutex> lock{m_listeners_mutex};
+
+    const unsigned int id = m_next_listener_id++;
+    m_commit_listeners.emplace(id, std::move(listener));
+
+    return ChangeSubscription{*this, id};
+}
+
+void Connection::follow(std::shared_ptr<Connection> writer) {
+    m_following.reset();
+    m_writer = std::move(writer);
+    m_following.emplace(m_writer->subscribe_committed(
+        [this](const Change change, StringView table, const int64_t rowid) {
+            notify(change, table, rowid);
+        }));
+}
+
+void Connection::notify_reset() {
+    notify(Change::Reset, "", 0);
+    if (sqlite3_get_autocommit(m_db.getHandle())) {
+        notify_committed();
+    }
+}
+
+void Connection::await_own_writes() const {
+    if (const auto* queue = m_write_queue.load(std::memory_order_acquire)) {
+        queue->sync();
+    } else if (m_writer) {
+        m_writer->await_own_writes();
+    }
+}
+
+void Connection::notify(const Change change,
+                        StringView table,
+                        const int64_t rowid) {
+    std::lock_guard<std::mutex> lock{m_listeners_mutex};
+
+    for (const auto& [id, listener] : m_listeners) {
+        listener(change, table, rowid);
+    }
+    if (!m_commit_listeners.empty()) {
+        m_uncommitted.push_back(PendingChange{change, String{table}, rowid});
+    }
+}
+
+void Connection::notify_rollback(const bool transaction_ended) {
+    std::lock_guard<std::mutex> lock{m_listeners_mutex};
+
+    if (transaction_ended) {
+        m_uncommitted.clear();
+    }
+    for (const auto& [id, listener] : m_listeners) {
+        listener(Change::Reset, "", 0);
+    }
+}
+
+void Connection::notify_committed() {
+    std::lock_guard<std::mutex> lock{m_listeners_mutex};
+
+    for (const auto& [change, table, rowid] : m_uncommitted) {
+        for (const auto& [id, listener] : m_commit_listeners) {
+            listener(change, table, rowid);
+        }
+    }
+    m_uncommitted.clear();
+}
+
+void Connection::unsubscribe(const unsigned int id) {
+    std::lock_guard<std::mutex> lock{m_listeners_mutex};
+    m_listeners.erase(id);
+    m_commit_listeners.erase(id);
+}
+
+ChangeSubscription& ChangeSubscription::operator=(
+    ChangeSubscription&& other) noexcept {
+    if (this != &other) {
+        if (m_connection) {
+            m_connection->unsubscribe(m_id);
+        }
+        m_connection = std::exchange(other.m_connection, nullptr);
+        m_id = other.m_id;
+    }
+
+    return *this;
+}
+
+ChangeSubscription::~ChangeSubscription() {
+    if (m_connection) {
+        m_connection->unsubscribe(m_id);
+    }
+}
+
+void Connection::apply_profile() {
+    m_db.setBusyTimeout(m_profile.busy_timeout_ms);
+
+    // The journal mode is stored in the file, and a reader never syncs.
+    if (m_role == ConnectionRole::Writer) {
+        m_db.exec(std::format(
+            "PRAGMA journal_mode = {};"
+            "PRAGMA synchronous = {};",
+            m_profile.journal_mode, m_profile.synchronous));
+    }
+    m_db.exec(std::format(
+        "PRAGMA mmap_size = {};"
+        "PRAGMA cache_size = -{};"
+        "PRAGMA temp_store = {};",
+        m_profile.mmap_size, m_profile.cache_size_kib, m_profile.temp_store));
+}
+
+UnitOfWork::UnitOfWork(SQL::Database& db) : m_db{db} {
+    m_db.exec("SAVEPOINT unit_of_work");
+}
+
+UnitOfWork::UnitOfWork(Connection& connection)
+    : m_db{connection.db()},
+      m_connection{&connection},
+      m_lock{connection.lock()} {
+    m_db.exec("SAVEPOINT unit_of_work");
+}
+
+UnitOfWork::~UnitOfWork() {
+    if (!m_done) {
+        try {
+            m_db.exec("ROLLBACK TO unit_of_work");
+            m_db.exec("RELEASE unit_of_work");
+        } catch (...) {
+        }
+
+        if (m_connection) {
+            m_connection->notify_rollback(
+                sqlite3_get_autocommit(m_db.getHandle()) != 0);
+        }
+    }
+}
+
+void UnitOfWork::commit() {
+    m_db.exec("RELEASE unit_of_work");
+    m_done = true;
+    if (m_lock) {
+        m_lock.unlock();
+    }
+}
+}  // namespace twodocore
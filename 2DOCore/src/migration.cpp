@@ -0,0 +1,177 @@
+#include "2DOCore/migration.hpp"
+
+#include "2DOCore/database.hpp"
+
+#include <SQLiteCpp/Statement.h>
+
+#include <chrono>
+
+namespace twodocore {
+namespace {
+constexpr const char* BASE_SCHEMA =
+    "CREATE TABLE IF NOT EXISTS users ("
+    "user_id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, "
+    "username VARCHAR(20) NOT NULL, "
+    "role BOOLEAN NOT NULL, "
+    "password VARCHAR(20) NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS tasks ("
+    "task_id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, "
+    "topic VARCHAR(20) NOT NULL, "
+    "content TEXT NOT NULL, "
+    "start_date VARCHAR(10) NOT NULL, "
+    "deadline VARCHAR(10) NOT NULL, "
+    "executor_id INTEGER NOT NULL, "
+    "owner_id INTEGER NOT NULL, "
+    "is_done BOOLEAN NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS messages ("
+    "message_id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, "
+    "task_id INTEGER NOT NULL, "
+    "sender_name VARCHAR(20) NOT NULL, "
+    "content VARCHAR(200) NOT NULL, "
+    "timestamp VARCHAR(10) NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS schema_version ("
+    "version INTEGER PRIMARY KEY NOT NULL, "
+    "description TEXT NOT NULL, "
+    "applied_at INTEGER NOT NULL);";
+}  // namespace
+
+const Vector<Migration>& migrations() {
+    static const Vector<Migration> list = {
+        {1, "Indexes on hot lookup columns",
+         "CREATE INDEX IF NOT EXISTS tasks_executor_id_idx "
+         "ON tasks (executor_id);"
+         "CREATE INDEX IF NOT EXISTS tasks_owner_id_idx ON tasks (owner_id);"
+         "CREATE INDEX IF NOT EXISTS messages_task_id_message_id_idx "
+         "ON messages (task_id, message_id);"
+         "CREATE UNIQUE INDEX IF NOT EXISTS users_username_idx "
+         "ON users (username);"},
+        {2, "Store timestamps as INTEGER minutes since epoch",
+         "CREATE TABLE tasks_new ("
+         "task_id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, "
+         "topic VARCHAR(20) NOT NULL, "
+         "content TEXT NOT NULL, "
+         "start_date INTEGER NOT NULL, "
+         "deadline INTEGER NOT NULL, "
+         "executor_id INTEGER NOT NULL, "
+         "owner_id INTEGER NOT NULL, "
+         "is_done BOOLEAN NOT NULL);"
+         "INSERT INTO tasks_new SELECT task_id, topic, content, "
+         "CAST(strftime('%s', start_date) AS INTEGER) / 60, "
+         "CAST(strftime('%s', deadline) AS INTEGER) / 60, "
+         "executor_id, owner_id, is_done FROM tasks;"
+         "DROP TABLE tasks;"
+         "ALTER TABLE tasks_new RENAME TO tasks;"
+         "CREATE INDEX tasks_executor_id_idx ON tasks (executor_id);"
+         "CREATE INDEX tasks_owner_id_idx ON tasks (owner_id);"
+         "CREATE TABLE messages_new ("
+         "message_id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, "
+         "task_id INTEGER NOT NULL, "
+         "sender_name VARCHAR(20) NOT NULL, "
+         "content VARCHAR(200) NOT NULL, "
+         "timestamp INTEGER NOT NULL);"
+         "INSERT INTO messages_new SELECT message_id, task_id, sender_name, "
+         "content, CAST(strftime('%s', timestamp) AS INTEGER) / 60 "
+         "FROM messages;"
+         "DROP TABLE messages;"
+         "ALTER TABLE messages_new RENAME TO messages;"
+         "CREATE INDEX messages_task_id_message_id_idx "
+         "ON messages (task_id, message_id);"},
+        {3, "Full-text search over tasks and messages",
+         "CREATE VIRTUAL TABLE tasks_fts USING fts5("
+         "topic, content, content='tasks', content_rowid='task_id', "
+         "prefix='2 3');"
+         "INSERT INTO tasks_fts (tasks_fts, rank) "
+         "VALUES ('rank', 'bm25(2.0, 1.0)');"
+         "INSERT INTO tasks_fts (tasks_fts) VALUES ('rebuild');"
+         "CREATE TRIGGER tasks_fts_insert AFTER INSERT ON tasks BEGIN "
+         "INSERT INTO tasks_fts (rowid, topic, content) "
+         "VALUES (new.task_id, new.topic, new.content); END;"
+         "CREATE TRIGGER tasks_fts_delete AFTER DELETE ON tasks BEGIN "
+         "INSERT INTO tasks_fts (tasks_fts, rowid, topic, content) "
+         "VALUES ('delete', old.task_id, old.topic, old.content); END;"
+         "CREATE TRIGGER tasks_fts_update AFTER UPDATE OF topic, content "
+         "ON tasks BEGIN "
+         "INSERT INTO tasks_fts (tasks_fts, rowid, topic, content) "
+         "VALUES ('delete', old.task_id, old.topic, old.content);"
+         "INSERT INTO tasks_fts (rowid, topic, content) "
+         "VALUES (new.task_id, new.topic, new.content); END;"
+         "CREATE VIRTUAL TABLE messages_fts USING fts5("
+         "content, content='messages', content_rowid='message_id', "
+         "prefix='2 3');"
+         "INSERT INTO messages_fts (messages_fts) VALUES ('rebuild');"
+         "CREATE TRIGGER messages_fts_insert AFTER INSERT ON messages BEGIN "
+         "INSERT INTO messages_fts (rowid, content) "
+         "VALUES (new.message_id, new.content); END;"
+         "CREATE TRIGGER messages_fts_delete AFTER DELETE ON messages BEGIN "
+         "INSERT INTO messages_fts (messages_fts, rowid, content) "
+         "VALUES ('delete', old.message_id, old.content); END;"
+         "CREATE TRIGGER messages_fts_update AFTER UPDATE OF content "
+         "ON messages BEGIN "
+         "INSERT INTO messages_fts (messages_fts, rowid, content) "
+         "VALUES ('delete', old.message_id, old.content);"
+         "INSERT INTO messages_fts (rowid, content) "
+         "VALUES (new.message_id, new.content); END;"},
+        {4, "Covering index for per-executor workload counts",
+         "CREATE INDEX tasks_workload_idx "
+         "ON tasks (executor_id, is_done, deadline);"},
+        {5, "Completion time of done tasks, for archiving",
+         "ALTER TABLE tasks ADD COLUMN done_at INTEGER;"
+         "UPDATE tasks SET done_at = "
+         "CAST(strftime('%s', 'now') AS INTEGER) / 60 WHERE is_done;"
+         "CREATE INDEX tasks_done_at_idx ON tasks (done_at) "
+         "WHERE done_at IS NOT NULL;"
+         "CREATE TRIGGER tasks_done_at_insert AFTER INSERT ON tasks "
+         "WHEN new.is_done AND new.done_at IS NULL BEGIN "
+         "UPDATE tasks SET done_at = "
+         "CAST(strftime('%s', 'now') AS INTEGER) / 60 "
+         "WHERE task_id = new.task_id; END;"
+         "CREATE TRIGGER tasks_done_at_update AFTER UPDATE OF is_done "
+         "ON tasks WHEN old.is_done IS NOT new.is_done BEGIN "
+         "UPDATE tasks SET done_at = CASE WHEN new.is_done THEN "
+         "CAST(strftime('%s', 'now') AS INTEGER) / 60 END "
+         "WHERE task_id = new.task_id; END;"},
+    };
+
+    return list;
+}
+
+unsigned int schema_version(const SQL::Database& db) {
+    if (!db.tableExists("schema_version")) {
+        return 0;
+    }
+
+    SQL::Statement query{db, "SELECT MAX(version) FROM schema_version"};
+    query.executeStep();
+
+    return (unsigned)query.getColumn(0).getInt();
+}
+
+void migrate(SQL::Database& db) {
+    UnitOfWork work{db};
+
+    db.exec(BASE_SCHEMA);
+
+    const unsigned int current = schema_version(db);
+    for (const auto& migration : migrations()) {
+        if (migration.version <= current) {
+            continue;
+        }
+
+        db.exec(String{migration.sql});
+
+        SQL::Statement query{db,
+                             "INSERT INTO schema_version (version, "
+                             "description, applied_at) VALUES (?, ?, ?)"};
+        query.bind(1, migration.version);
+        query.bind(2, String{migration.description});
+        query.bind(3, static_cast<int64_t>(
+                          std::chrono::duration_cast<std::chrono::seconds>(
+                              std::chrono::system_clock::now()
+                                  .time_since_epoch())
+                              .count()));
+        query.exec();
+    }
+
+    work.commit();
+}
+}  // namespace twodocore
@@ -0,0 +1,64 @@
+#include "2DOCore/notifier.hpp"
+
+#include <SQLiteCpp/Statement.h>
+
+namespace twodocore {
+ChangeNotifier::ChangeNotifier(Connection& connection,
+                               StringView table,
+                               const sch::milliseconds poll_interval)
+    : m_connection{connection},
+      m_poll_interval{poll_interval},
+      m_data_version{read_data_version()},
+      m_subscription{connection.subscribe(
+          [this, table](const Change change, StringView changed, int64_t) {
+              if (change == Change::Reset || changed == table) {
+                  bump();
+              }
+          })} {}
+
+std::uint64_t ChangeNotifier::version() const {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_version;
+}
+
+std::uint64_t ChangeNotifier::wait(const std::uint64_t seen,
+                                   std::stop_token stop) {
+    std::unique_lock<std::mutex> lock{m_mutex};
+
+    while (!stop.stop_requested()) {
+        if (m_changed.wait_for(lock, stop, m_poll_interval,
+                               [&] { return m_version != seen; })) {
+            break;
+        }
+        if (stop.stop_requested()) {
+            break;
+        }
+
+        lock.unlock();
+        const int64_t data_version = read_data_version();
+        lock.lock();
+
+        if (data_version != m_data_version) {
+            m_data_version = data_version;
+            ++m_version;
+        }
+    }
+
+    return m_version;
+}
+
+int64_t ChangeNotifier::read_data_version() const {
+    SQL::Statement query{m_connection.db(), "PRAGMA data_version"};
+    query.executeStep();
+
+    return query.getColumn(0).getInt64();
+}
+
+void ChangeNotifier::bump() {
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        ++m_version;
+    }
+    m_changed.notify_all();
+}
+}  // namespace twodocore
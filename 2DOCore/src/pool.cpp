@@ -0,0 +1,77 @@
+#include "2DOCore/pool.hpp"
+
+#include <algorithm>
+
+namespace twodocore {
+ReaderLease& ReaderLease::operator=(ReaderLease&& other) noexcept {
+    if (this != &other) {
+        if (m_pool) {
+            m_pool->release(std::move(m_connection));
+        }
+        m_pool = std::exchange(other.m_pool, nullptr);
+        m_connection = std::move(other.m_connection);
+    }
+
+    return *this;
+}
+
+ReaderLease::~ReaderLease() {
+    if (m_pool) {
+        m_pool->release(std::move(m_connection));
+    }
+}
+
+ConnectionPool::ConnectionPool(const fs::path& db_filepath,
+                               const ConnectionProfile& profile,
+                               const std::size_t max_readers)
+    : m_db_filepath{db_filepath},
+      m_profile{profile},
+      m_max_readers{std::max<std::size_t>(max_readers, 1)},
+      m_writer{std::make_shared<Connection>(m_db_filepath, m_profile)} {}
+
+ReaderLease ConnectionPool::acquire_reader() {
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_returned.wait(lock, [&] {
+            return !m_idle.empty() || m_open < m_max_readers;
+        });
+
+        if (!m_idle.empty()) {
+            auto connection = std::move(m_idle.back());
+            m_idle.pop_back();
+            return ReaderLease{*this, std::move(connection)};
+        }
+        ++m_open;
+    }
+
+    // Opened outside the lock, so other threads can take idle readers
+    // meanwhile.
+    try {
+        auto connection = std::make_shared<Connection>(
+            m_db_filepath, m_profile, ConnectionRole::Reader);
+        connection->follow(m_writer);
+
+        return ReaderLease{*this, std::move(connection)};
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            --m_open;
+        }
+        m_returned.notify_one();
+        throw;
+    }
+}
+
+PoolStats ConnectionPool::stats() const {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return PoolStats{m_open, m_open - m_idle.size()};
+}
+
+void ConnectionPool::release(std::shared_ptr<Connection> connection) {
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_idle.push_back(std::move(connection));
+    }
+    m_returned.notify_one();
+}
+}  // namespace twodocore
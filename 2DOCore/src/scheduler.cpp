@@ -0,0 +1,306 @@
+#include "2DOCore/scheduler.hpp"
+
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Statement.h>
+
+#include <algorithm>
+#include <bit>
+#include <tuple>
+#include <utility>
+
+namespace twodocore {
+void TimerWheel::schedule(const unsigned int id, const int64_t due) {
+    cancel(id);
+
+    Slot& slot = slot_for(due);
+    slot.push_back(Timer{id, due});
+    m_index.insert_or_assign(id, Location{&slot, std::prev(slot.end())});
+}
+
+bool TimerWheel::cancel(const unsigned int id) {
+    const auto it = m_index.find(id);
+    if (it == m_index.end()) {
+        return false;
+    }
+
+    it->second.slot->erase(it->second.timer);
+    m_index.erase(it);
+
+    return true;
+}
+
+void TimerWheel::clear() {
+    for (auto& level : m_levels) {
+        for (auto& slot : level) {
+            slot.clear();
+        }
+    }
+    m_overflow.clear();
+    m_expired.clear();
+    m_index.clear();
+}
+
+Vector<TimerWheel::Timer> TimerWheel::advance(const int64_t now) {
+    Vector<Timer> fired;
+    collect(m_expired, fired);
+
+    while (m_now < now && !m_index.empty()) {
+        m_now = std::min(now, next_tick());
+
+        // Higher levels first, as their timers may land in a lower slot
+        // that comes round on this same tick.
+        if (m_now % (int64_t{1} << (SLOT_BITS * LEVELS)) == 0) {
+            cascade(m_overflow);
+        }
+        for (std::size_t level = LEVELS - 1; level > 0; --level) {
+            const int shift = SLOT_BITS * static_cast<int>(level);
+            if (m_now % (int64_t{1} << shift) == 0) {
+                cascade(m_levels[level][(m_now >> shift) & (SLOTS - 1)]);
+            }
+        }
+
+        collect(m_levels[0][m_now & (SLOTS - 1)], fired);
+        collect(m_expired, fired);
+    }
+    m_now = std::max(m_now, now);
+
+    return fired;
+}
+
+int64_t TimerWheel::next_tick() const {
+    const auto is_empty = [](const Slot& slot) { return slot.empty(); };
+
+    // Only the lowest occupied level matters; nothing below it can fire
+    // before its next slot comes round.
+    std::size_t level = 0;
+    while (level < LEVELS && std::ranges::all_of(m_levels[level], is_empty)) {
+        ++level;
+    }
+
+    const int64_t span = int64_t{1} << (SLOT_BITS * static_cast<int>(level));
+    return (m_now / span + 1) * span;
+}
+
+TimerWheel::Slot& TimerWheel::slot_for(const int64_t due) {
+    if (due <= m_now) {
+        return m_expired;
+    }
+
+    // The highest base-64 digit where due differs from now picks the level.
+    const auto differing = static_cast<uint64_t>(due ^ m_now);
+    const auto level = static_cast<std::size_t>(
+        (std::bit_width(differing) - 1) / SLOT_BITS);
+    if (level >= LEVELS) {
+        return m_overflow;
+    }
+
+    const int shift = SLOT_BITS * static_cast<int>(level);
+    return m_levels[level][(due >> shift) & (SLOTS - 1)];
+}
+
+void TimerWheel::cascade(Slot& slot) {
+    Slot moving;
+    moving.splice(moving.end(), slot);
+
+    while (!moving.empty()) {
+        const auto timer = moving.begin();
+        Slot& target = slot_for(timer->due);
+        target.splice(target.end(), moving, timer);
+        m_index.at(timer->id).slot = &target;
+    }
+}
+
+void TimerWheel::collect(Slot& slot, Vector<Timer>& fired) {
+    for (const auto& timer : slot) {
+        fired.push_back(timer);
+        m_index.erase(timer.id);
+    }
+    slot.clear();
+}
+
+DeadlineScheduler::DeadlineScheduler(std::shared_ptr<Connection> connection,
+                                     const sch::minutes lead_time,
+                                     const TimePoint now)
+    : m_connection{std::move(connection)},
+      m_statements{std::make_unique<StatementCache>(*m_connection)},
+      m_lead_time{lead_time},
+      m_wheel{tdu::to_epoch_minutes(now)},
+      m_subscription{m_connection->subscribe(
+          [this](const Change change, StringView table, const int64_t rowid) {
+              if (change == Change::Reset || table == "tasks") {
+                  on_change(change, rowid);
+              }
+          })} {}
+
+std::size_t DeadlineScheduler::pending() const {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_deadlines.size();
+}
+
+Vector<Reminder> DeadlineScheduler::poll(const TimePoint now) {
+    std::unordered_set<unsigned int> dirty;
+    bool reload = false;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        dirty.swap(m_dirty);
+        reload = std::exchange(m_reload, false);
+    }
+
+    // The database is read without holding the lock: a writer on another
+    // thread holds the connection while its update hook waits for it.
+    Vector<std::pair<unsigned int, std::optional<int64_t>>> changes;
+    try {
+        if (reload) {
+            auto query = m_statements->acquire(
+                "SELECT task_id, deadline FROM tasks WHERE is_done = 0");
+            while (query->executeStep()) {
+                changes.emplace_back((unsigned)query->getColumn(0).getInt64(),
+                                     query->getColumn(1).getInt64());
+            }
+        } else {
+            changes.reserve(dirty.size());
+            for (const unsigned int id : dirty) {
+                changes.emplace_back(id, read_open_deadline(id));
+            }
+        }
+    } catch (const SQL::Exception&) {
+        // Leave the changes for the next poll.
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_dirty.merge(dirty);
+        m_reload = m_reload || reload;
+        throw;
+    }
+
+    Vector<std::tuple<Reminder::Kind, unsigned int, int64_t>> fired;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        if (reload) {
+            m_wheel.clear();
+            m_deadlines.clear();
+        }
+        for (const auto& [id, deadline] : changes) {
+            if (deadline) {
+                track(id, *deadline);
+            } else {
+                untrack(id);
+            }
+        }
+
+        const int64_t minutes = tdu::to_epoch_minutes(now);
+        for (const auto& [id, due] : m_wheel.advance(minutes)) {
+            const int64_t deadline = m_deadlines.at(id);
+            if (due < deadline) {
+                fired.emplace_back(Reminder::Kind::DueSoon, id, deadline);
+                m_wheel.schedule(id, deadline);
+            } else {
+                fired.emplace_back(Reminder::Kind::Overdue, id, deadline);
+                m_deadlines.erase(id);
+            }
+        }
+    }
+
+    Vector<Reminder> reminders;
+    reminders.reserve(fired.size());
+    for (const auto& [kind, id, deadline] : fired) {
+        if (auto reminder = read_reminder(kind, id, deadline)) {
+            reminders.push_back(std::move(*reminder));
+        }
+    }
+
+    return reminders;
+}
+
+void DeadlineScheduler::start(ReminderListener listener) {
+    m_thread = std::jthread{[this, listener = std::move(listener)](
+                                std::stop_token stop) {
+        while (!stop.stop_requested()) {
+            // A failed poll is retried on the next wake-up.
+            try {
+                for (const auto& reminder :
+                     poll(tdu::get_current_timestamp())) {
+                    listener(reminder);
+                }
+            } catch (const SQL::Exception&) {
+            }
+
+            const auto next_minute =
+                sch::floor<sch::minutes>(sch::system_clock::now()) +
+                sch::minutes{1};
+
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_changed.wait_until(lock, stop, next_minute, [&] {
+                return m_reload || !m_dirty.empty();
+            });
+        }
+    }};
+}
+
+void DeadlineScheduler::on_change(const Change change, const int64_t rowid) {
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        if (change == Change::Reset) {
+            m_reload = true;
+            m_dirty.clear();
+        } else {
+            m_dirty.insert(static_cast<unsigned int>(rowid));
+        }
+    }
+    m_changed.notify_all();
+}
+
+void DeadlineScheduler::track(const unsigned int id, const int64_t deadline) {
+    if (deadline <= m_wheel.now()) {
+        untrack(id);
+        return;
+    }
+
+    // Edits to other columns must not repeat a reminder already given.
+    if (const auto it = m_deadlines.find(id);
+        it != m_deadlines.end() && it->second == deadline) {
+        return;
+    }
+
+    m_deadlines.insert_or_assign(id, deadline);
+    m_wheel.schedule(id, deadline - m_lead_time.count());
+}
+
+void DeadlineScheduler::untrack(const unsigned int id) {
+    m_deadlines.erase(id);
+    m_wheel.cancel(id);
+}
+
+std::optional<int64_t> DeadlineScheduler::read_open_deadline(
+    const unsigned int id) const {
+    auto query = m_statements->acquire(
+        "SELECT deadline FROM tasks WHERE task_id = ? AND is_done = 0");
+    query->bind(1, id);
+
+    if (!query->executeStep()) {
+        return std::nullopt;
+    }
+
+    return query->getColumn(0).getInt64();
+}
+
+std::optional<Reminder> DeadlineScheduler::read_reminder(
+    const Reminder::Kind kind,
+    const unsigned int id,
+    const int64_t deadline) const {
+    auto query = m_statements->acquire(
+        "SELECT topic, executor_id, owner_id FROM tasks WHERE task_id = ?");
+    query->bind(1, id);
+
+    if (!query->executeStep()) {
+        return std::nullopt;
+    }
+
+    return Reminder{kind,
+                    id,
+                    query->getColumn(0).getString(),
+                    tdu::from_epoch_minutes(deadline),
+                    (unsigned)query->getColumn(1).getInt64(),
+                    (unsigned)query->getColumn(2).getInt64()};
+}
+}  // namespace twodocore
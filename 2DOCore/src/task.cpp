@@ -2,52 +2,158 @@
 
 #include <SQLiteCpp/Statement.h>
 
+#include <algorithm>
+#include <ranges>
+#include <utility>
+
 namespace twodocore {
-TaskDb::TaskDb(const fs::path& db_filepath)
-    : m_db{db_filepath, SQL::OPEN_READWRITE} {
-    if (!m_db.tableExists("tasks")) {
-        SQL::Statement query{
-            m_db,
-            "CREATE TABLE IF NOT EXISTS tasks ("
-            "task_id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, "
-            "topic VARCHAR(20) NOT NULL, "
-            "content TEXT NOT NULL, "
-            "start_date VARCHAR(10) NOT NULL, "
-            "deadline VARCHAR(10) NOT NULL, "
-            "executor_id INTEGER NOT NULL, "
-            "owner_id INTEGER NOT NULL, "
-            "is_done BOOLEAN NOT NULL)"};
-
-        query.exec();
-        if (!query.isDone()) {
-            throw std::runtime_error("Failure creating tasks table.");
+namespace {
+// Each source is cut to this many times the limit before the hits are
+// grouped by task, so FTS5 can stop early instead of ranking every match.
+// Only the user's tasks are counted against it.
+constexpr unsigned int SEARCH_OVERFETCH = 4;
+
+constexpr const char* SEARCH_SQL =
+    "WITH matches (task_id, snippet, rank) AS ("
+    "SELECT * FROM (SELECT tasks_fts.rowid, "
+    "snippet(tasks_fts, -1, '[', ']', '...', 12), tasks_fts.rank "
+    "FROM tasks_fts JOIN tasks t ON t.task_id = tasks_fts.rowid "
+    "WHERE tasks_fts MATCH ?1 AND (t.owner_id = ?4 OR t.executor_id = ?4) "
+    "ORDER BY tasks_fts.rank LIMIT ?2) "
+    "UNION ALL "
+    "SELECT * FROM (SELECT m.task_id, "
+    "snippet(messages_fts, 0, '[', ']', '...', 12), messages_fts.rank "
+    "FROM messages_fts JOIN messages m ON m.message_id = messages_fts.rowid "
+    "JOIN tasks t ON t.task_id = m.task_id "
+    "WHERE messages_fts MATCH ?1 AND (t.owner_id = ?4 OR t.executor_id = ?4) "
+    "ORDER BY messages_fts.rank LIMIT ?2)) "
+    "SELECT t.task_id, t.topic, m.snippet, t.owner_id, t.executor_id, "
+    "MIN(m.rank) AS best FROM matches m "
+    "JOIN tasks t ON t.task_id = m.task_id "
+    "WHERE t.owner_id = ?4 OR t.executor_id = ?4 "
+    "GROUP BY t.task_id ORDER BY best LIMIT ?3";
+
+constexpr const char* WORKLOAD_SQL =
+    "SELECT u.user_id, u.username, "
+    "COUNT(t.task_id) FILTER (WHERE t.is_done = 0), "
+    "COUNT(t.task_id) FILTER (WHERE t.is_done <> 0), "
+    "COUNT(t.task_id) FILTER (WHERE t.is_done = 0 AND t.deadline < ?1), "
+    "COUNT(t.task_id) FILTER "
+    "(WHERE t.is_done = 0 AND t.deadline >= ?1 AND t.deadline < ?2) "
+    "FROM users u LEFT JOIN tasks t ON t.executor_id = u.user_id "
+    "GROUP BY u.user_id ORDER BY u.user_id";
+
+// Quotes every word, so user input is never read as FTS5 syntax. The last
+// word matches as a prefix, for a query that is still being typed.
+String to_match_expression(StringView query) {
+    String expression;
+
+    for (const auto word : query | std::views::split(' ')) {
+        if (std::ranges::empty(word)) {
+            continue;
+        }
+
+        expression += expression.empty() ? "\"" : " \"";
+        for (const char c : word) {
+            if (c == '"') {
+                expression += '"';
+            }
+            expression += c;
         }
+        expression += '"';
+    }
+
+    if (!expression.empty()) {
+        expression += '*';
     }
+
+    return expression;
 }
+}  // namespace
+
+TaskDb::TaskDb(std::shared_ptr<Connection> connection)
+    : m_connection{std::move(connection)},
+      m_statements{std::make_unique<StatementCache>(*m_connection)},
+      m_cache{std::make_unique<IdentityMap<Task>>()},
+      m_subscription{
+          watch_table(*m_connection, Schema<Task>::table, *m_cache)} {}
 
 Task TaskDb::get_object(const unsigned int id) const {
-    SQL::Statement query{m_db, "SELECT * FROM tasks WHERE task_id = ?"};
-    query.bind(1, id);
+    m_connection->await_own_writes();
+    if (auto task = m_cache->find(id)) {
+        return std::move(task.value());
+    }
+
+    const auto generation = m_cache->generation();
+    auto query =
+        m_statements->acquire(select_sql<Task, " WHERE task_id = ?">());
+    query->bind(1, id);
+
+    query->executeStep();
+
+    Task task = read_row<Task>(*query);
+    m_cache->fill(id, task, generation);
+
+    return task;
+}
+
+Vector<SearchHit> TaskDb::search(StringView query,
+                                 const unsigned int user_id,
+                                 const unsigned int limit) const {
+    m_connection->await_own_writes();
+    const String expression = to_match_expression(query);
+    if (expression.empty() || limit == 0) {
+        return {};
+    }
 
-    query.executeStep();
+    auto statement = m_statements->acquire(SEARCH_SQL);
+    statement->bind(1, expression);
+    statement->bind(2, static_cast<int64_t>(limit) * SEARCH_OVERFETCH);
+    statement->bind(3, limit);
+    statement->bind(4, user_id);
+
+    Vector<SearchHit> hits;
+    while (statement->executeStep()) {
+        hits.push_back(
+            SearchHit{(unsigned)statement->getColumn(0).getInt64(),
+                      statement->getColumn(1).getString(),
+                      statement->getColumn(2).getString(),
+                      (unsigned)statement->getColumn(3).getInt64(),
+                      (unsigned)statement->getColumn(4).getInt64()});
+    }
+
+    return hits;
+}
+
+Vector<WorkloadStats> TaskDb::workload_stats(
+    const TimePoint now,
+    const sch::days due_within) const {
+    m_connection->await_own_writes();
+    auto query = m_statements->acquire(WORKLOAD_SQL);
+    query->bind(1, tdu::to_epoch_minutes(now));
+    query->bind(2, tdu::to_epoch_minutes(now + due_within));
+
+    Vector<WorkloadStats> stats;
+    while (query->executeStep()) {
+        stats.push_back(WorkloadStats{(unsigned)query->getColumn(0).getInt64(),
+                                      query->getColumn(1).getString(),
+                                      (unsigned)query->getColumn(2).getInt(),
+                                      (unsigned)query->getColumn(3).getInt(),
+                                      (unsigned)query->getColumn(4).getInt(),
+                                      (unsigned)query->getColumn(5).getInt()});
+    }
 
-    return Task{(unsigned)query.getColumn(0).getInt(),
-                query.getColumn(1).getString(),
-                query.getColumn(2).getString(),
-                query.getColumn(3).getString(),
-                query.getColumn(4).getString(),
-                (unsigned)query.getColumn(5).getInt(),
-                (unsigned)query.getColumn(6).getInt(),
-                (unsigned)query.getColumn(7).getInt()};
+    return stats;
 }
 
 bool TaskDb::is_table_empty() const {
+    m_connection->await_own_writes();
     int count = 0;
 
     try {
-        SQLite::Statement query(m_db, "SELECT COUNT(*) FROM tasks");
-        if (query.executeStep()) {
-            count = query.getColumn(0).getInt();
+        auto query = m_statements->acquire("SELECT COUNT(*) FROM tasks");
+        if (query->executeStep()) {
+            count = query->getColumn(0).getInt();
         }
     } catch (SQLite::Exception& e) {
         return true;
@@ -56,139 +162,154 @@ bool TaskDb::is_table_empty() const {
     return count == 0;
 }
 
-void TaskDb::add_object(Task& task) const {
-    SQL::Statement query{
-        m_db,
-        "INSERT INTO tasks (topic, content, start_date, deadline, "
-        "executor_id, owner_id, is_done) VALUES (?, ?, ?, ?, "
-        "?, ?, ?)"};
-    query.bind(1, task.topic());
-    query.bind(2, task.content());
-    query.bind(3, task.start_date<String>());
-    query.bind(4, task.deadline<String>());
-    query.bind(5, task.executor_id());
-    query.bind(6, task.owner_id());
-    query.bind(7, task.is_done());
-
-    query.exec();
-
-    query = SQL::Statement{
-        m_db, "SELECT task_id FROM tasks ORDER BY task_id DESC LIMIT 1"};
-
-    query.executeStep();
+unsigned int TaskDb::add_object(Task& task) const {
+    const unsigned int id = add_object(std::as_const(task));
+    task.set_id(id);
 
-    task.set_id(std::stoi(query.getColumn(0)));
+    return id;
 }
 
-void TaskDb::add_object(const Task& task) const {
-    SQL::Statement query{
-        m_db,
-        "INSERT INTO tasks (topic, content, start_date, deadline, "
-        "executor_id, owner_id, is_done) VALUES (?, ?, ?, ?, "
-        "?, ?, ?)"};
-    query.bind(1, task.topic());
-    query.bind(2, task.content());
-    query.bind(3, task.start_date<String>());
-    query.bind(4, task.deadline<String>());
-    query.bind(5, task.executor_id());
-    query.bind(6, task.owner_id());
-    query.bind(7, task.is_done());
+unsigned int TaskDb::add_object(const Task& task) const {
+    auto query = m_statements->acquire(insert_sql<Task>());
+    bind_columns(*query, task);
 
-    query.exec();
+    query->exec();
 
-    query = SQL::Statement{
-        m_db, "SELECT task_id FROM tasks ORDER BY task_id DESC LIMIT 1"};
-
-    query.executeStep();
+    return static_cast<unsigned int>(m_connection->db().getLastInsertRowid());
 }
 
 void TaskDb::update_object(const Task& task) const {
-    SQL::Statement query{
-        m_db,
-        "UPDATE tasks SET topic = ?, content = ?, start_date = ?, deadline "
-        "= ?, executor_id = ?, owner_id = ?, is_done = ? "
-        "WHERE task_id = ?"};
-    query.bind(1, task.topic());
-    query.bind(2, task.content());
-    query.bind(3, task.start_date<String>());
-    query.bind(4, task.deadline<String>());
-    query.bind(5, task.executor_id());
-    query.bind(6, task.owner_id());
-    query.bind(7, task.is_done());
-    query.bind(8, task.id());
-
-    query.exec();
+    auto query = m_statements->acquire(update_sql<Task>());
+    bind_columns_and_key(*query, task);
+
+    query->exec();
+    m_cache->put(task.id(), task);
 }
 
 void TaskDb::delete_object(const unsigned int id) const {
-    SQL::Statement query{m_db, "DELETE FROM tasks WHERE task_id = ?"};
-    query.bind(1, std::to_string(id));
-
-    query.exec();
-}
-
-MessageDb::MessageDb(const fs::path& db_filepath)
-    : m_db{db_filepath, SQL::OPEN_READWRITE} {
-    if (!m_db.tableExists("messages")) {
-        SQL::Statement query{
-            m_db,
-            "CREATE TABLE IF NOT EXISTS messages ("
-            "message_id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, "
-            "task_id INTEGER NOT NULL, "
-            "sender_name VARCHAR(20) NOT NULL, "
-            "content VARCHAR(200) NOT NULL, "
-            "timestamp VARCHAR(10) NOT NULL)"};
-
-        query.exec();
-        if (!query.isDone())
-            throw std::runtime_error("Failure creating messages table.");
-    }
+    auto query = m_statements->acquire("DELETE FROM tasks WHERE task_id = ?");
+    query->bind(1, id);
+
+    query->exec();
+    m_cache->erase(id);
 }
 
+MessageDb::MessageDb(std::shared_ptr<Connection> connection)
+    : m_connection{std::move(connection)},
+      m_statements{std::make_unique<StatementCache>(*m_connection)},
+      m_changes{
+          std::make_unique<ChangeNotifier>(*m_connection, "messages")} {}
+
 std::optional<Message> MessageDb::get_newest_object() const {
-    SQL::Statement query{
-        m_db, "SELECT * FROM messages ORDER BY message_id DESC LIMIT 1"};
+    m_connection->await_own_writes();
+    auto query = m_statements->acquire(
+        select_sql<Message, " ORDER BY message_id DESC LIMIT 1">());
 
     try {
-        if (!query.executeStep()) {
+        if (!query->executeStep()) {
             return std::nullopt;
         }
     } catch (const std::exception& e) {
-        if (query.hasRow()) {
+        if (query->hasRow()) {
             throw e;
         }
     }
 
-    return Message{(unsigned)query.getColumn(0).getInt(),
-                   (unsigned)query.getColumn(1).getInt(),
-                   query.getColumn(2).getString(),
-                   query.getColumn(3).getString(),
-                   tdu::to_time_point(query.getColumn(4).getString()).value()};
+    return read_row<Message>(*query);
+}
+
+std::optional<unsigned int> MessageDb::get_newest_id(
+    const unsigned int task_id) const {
+    m_connection->await_own_writes();
+    auto query = m_statements->acquire(
+        "SELECT MAX(message_id) FROM messages WHERE task_id = ?");
+    query->bind(1, task_id);
+    query->executeStep();
+
+    const auto newest = query->getColumn(0);
+    if (newest.isNull()) {
+        return std::nullopt;
+    }
+
+    return static_cast<unsigned int>(newest.getInt64());
+}
+
+Vector<Message> MessageDb::get_messages_since(const unsigned int task_id,
+                                              const unsigned int last_id,
+                                              const int limit) const {
+    m_connection->await_own_writes();
+    auto query = m_statements->acquire(
+        select_sql<Message, " WHERE task_id = ? AND message_id > ? "
+                            "ORDER BY message_id LIMIT ?">());
+    query->bind(1, task_id);
+    query->bind(2, last_id);
+    query->bind(3, limit);
+
+    Vector<Message> messages;
+    while (query->executeStep()) {
+        messages.push_back(read_row<Message>(*query));
+    }
+
+    return messages;
+}
+
+Vector<Message> MessageDb::get_last_n(const unsigned int task_id,
+                                      const unsigned int n) const {
+    m_connection->await_own_writes();
+    auto query = m_statements->acquire(
+        select_sql<Message, " WHERE task_id = ? "
+                            "ORDER BY message_id DESC LIMIT ?">());
+    query->bind(1, task_id);
+    query->bind(2, n);
+
+    Vector<Message> messages;
+    while (query->executeStep()) {
+        messages.push_back(read_row<Message>(*query));
+    }
+    std::ranges::reverse(messages);
+
+    return messages;
 }
 
 Vector<Message> MessageDb::get_all_objects(const unsigned int taks_id) const {
-    SQL::Statement query{m_db, "SELECT * FROM messages WHERE task_id = ?"};
-    query.bind(1, taks_id);
+    m_connection->await_own_writes();
+    auto query =
+        m_statements->acquire(select_sql<Message, " WHERE task_id = ?">());
+    query->bind(1, taks_id);
 
     Vector<Message> messages;
-    while (query.executeStep()) {
-        messages.push_back(Message{
-            (unsigned)query.getColumn(0).getInt(),
-            (unsigned)query.getColumn(1).getInt(),
-            query.getColumn(2).getString(), query.getColumn(3).getString(),
-            tdu::to_time_point(query.getColumn(4).getString()).value()});
+    while (query->executeStep()) {
+        messages.push_back(read_row<Message>(*query));
     }
 
     return messages;
 };
 
+PmrVector<Message> MessageDb::get_all_objects(
+    const unsigned int task_id,
+    std::pmr::memory_resource* resource) const {
+    m_connection->await_own_writes();
+    auto query =
+        m_statements->acquire(select_sql<Message, " WHERE task_id = ?">());
+    query->bind(1, task_id);
+
+    PmrVector<Message> messages{resource};
+    while (query->executeStep()) {
+        messages.push_back(
+            read_row<Message>(*query, messages.get_allocator()));
+    }
+
+    return messages;
+}
+
 bool MessageDb::is_table_empty() const {
+    m_connection->await_own_writes();
     int count = 0;
 
     try {
-        SQLite::Statement query(m_db, "SELECT COUNT(*) FROM messages");
-        if (query.executeStep()) {
-            count = query.getColumn(0).getInt();
+        auto query = m_statements->acquire("SELECT COUNT(*) FROM messages");
+        if (query->executeStep()) {
+            count = query->getColumn(0).getInt();
         }
     } catch (SQLite::Exception& e) {
         return true;
@@ -197,48 +318,36 @@ bool MessageDb::is_table_empty() const {
     return count == 0;
 }
 
-void MessageDb::add_object(Message& message) const {
-    SQL::Statement query{m_db,
-                         "INSERT INTO messages (task_id, sender_name, "
-                         "content, timestamp) VALUES (?, ?, ?, ?)"};
-    query.bind(1, message.task_id());
-    query.bind(2, message.sender_name());
-    query.bind(3, message.content());
-    query.bind(4, message.timestamp<String>());
-
-    query.exec();
+unsigned int MessageDb::add_object(Message& message) const {
+    const unsigned int id = add_object(std::as_const(message));
+    message.set_message_id(id);
 
-    query = SQL::Statement{
-        m_db,
-        "SELECT message_id FROM messages ORDER BY message_id DESC LIMIT 1"};
-
-    query.executeStep();
+    return id;
+}
 
-    message.set_message_id(std::stoi(query.getColumn(0)));
-};
+unsigned int MessageDb::add_object(const Message& message) const {
+    auto query = m_statements->acquire(insert_sql<Message>());
+    bind_columns(*query, message);
 
-void MessageDb::add_object(const Message& message) const {
-    SQL::Statement query{m_db,
-                         "INSERT INTO messages (task_id, sender_name, "
-                         "content, timestamp) VALUES (?, ?, ?, ?)"};
-    query.bind(1, message.task_id());
-    query.bind(2, message.sender_name());
-    query.bind(3, message.content());
-    query.bind(4, message.timestamp<String>());
+    query->exec();
 
-    query.exec();
+    return static_cast<unsigned int>(m_connection->db().getLastInsertRowid());
+}
 
-    query = SQL::Statement{
-        m_db,
-        "SELECT message_id FROM messages ORDER BY message_id DESC LIMIT 1"};
+void MessageDb::delete_all_by_task_id(const unsigned int task_id) const {
+    auto query = m_statements->acquire(
+        "DELETE FROM messages WHERE task_id = ?");
+    query->bind(1, task_id);
 
-    query.executeStep();
+    query->exec();
 }
 
-void MessageDb::delete_all_by_task_id(const unsigned int task_id) const {
-    SQL::Statement query{m_db, "DELETE FROM messages WHERE task_id = ?"};
-    query.bind(1, task_id);
+std::uint64_t MessageDb::change_version() const {
+    return m_changes->version();
+}
 
-    query.exec();
+std::uint64_t MessageDb::wait_for_change(const std::uint64_t seen,
+                                         std::stop_token stop) const {
+    return m_changes->wait(seen, std::move(stop));
 }
 }  // namespace twodocore
\ No newline at end of file
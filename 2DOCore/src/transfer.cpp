@@ -0,0 +1,747 @@
+#include "2DOCore/transfer.hpp"
+
+#include <SQLiteCpp/Statement.h>
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "2DOCore/schema.hpp"
+
+namespace twodocore {
+namespace {
+void check_table(StringView table) {
+    if (std::ranges::find(TRANSFER_TABLES, table) == TRANSFER_TABLES.end()) {
+        throw std::runtime_error("Unknown table: " + String{table});
+    }
+}
+
+class BufferedWriter {
+  public:
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    explicit BufferedWriter(const fs::path& path)
+        : m_file{std::fopen(path.string().c_str(), "wb")} {
+        if (!m_file) {
+            throw std::runtime_error("Cannot open " + path.string());
+        }
+    }
+
+    ~BufferedWriter() {
+        if (m_file) {
+            std::fclose(m_file);
+        }
+    }
+
+    void put(const char c) {
+        if (m_size == TRANSFER_BUFFER_SIZE) {
+            flush();
+        }
+        m_buffer[m_size++] = c;
+    }
+
+    void write(StringView text) {
+        if (text.size() > TRANSFER_BUFFER_SIZE - m_size) {
+            flush();
+        }
+        if (text.size() >= TRANSFER_BUFFER_SIZE) {
+            write_through(text);
+            return;
+        }
+
+        std::memcpy(m_buffer.get() + m_size, text.data(), text.size());
+        m_size += text.size();
+    }
+
+    void close() {
+        flush();
+        const bool failed = std::fclose(std::exchange(m_file, nullptr)) != 0;
+        if (failed) {
+            throw std::runtime_error("Failed to write the export file.");
+        }
+    }
+
+  private:
+    std::FILE* m_file;
+    std::unique_ptr<char[]> m_buffer =
+        std::make_unique<char[]>(TRANSFER_BUFFER_SIZE);
+    std::size_t m_size = 0;
+
+    void flush() {
+        write_through({m_buffer.get(), m_size});
+        m_size = 0;
+    }
+
+    void write_through(StringView text) {
+        if (std::fwrite(text.data(), 1, text.size(), m_file) != text.size()) {
+            throw std::runtime_error("Failed to write the export file.");
+        }
+    }
+};
+
+// Read-only mapping of a whole file; pages are read in on demand and can be
+// dropped again by the OS, so a file of any size costs constant memory.
+class MappedFile {
+  public:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    explicit MappedFile(const fs::path& path) {
+#ifdef _WIN32
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             nullptr, OPEN_EXISTING,
+                             FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER size{};
+        if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size)) {
+            throw std::runtime_error("Cannot open " + path.string());
+        }
+        m_size = static_cast<std::size_t>(size.QuadPart);
+        if (m_size == 0) {
+            return;
+        }
+
+        m_mapping =
+            CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping) {
+            m_data = static_cast<const char*>(
+                MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+#else
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        struct stat info{};
+        if (m_fd < 0 || ::fstat(m_fd, &info) != 0) {
+            throw std::runtime_error("Cannot open " + path.string());
+        }
+        m_size = static_cast<std::size_t>(info.st_size);
+        if (m_size == 0) {
+            return;
+        }
+
+        void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (data != MAP_FAILED) {
+            ::madvise(data, m_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const char*>(data);
+        }
+#endif
+        if (!m_data) {
+            throw std::runtime_error("Cannot map " + path.string());
+        }
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (m_data) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+        }
+#else
+        if (m_data) {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+#endif
+    }
+
+    [[nodiscard]] StringView view() const {
+        return m_data ? StringView{m_data, m_size} : StringView{};
+    }
+
+  private:
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+StringView column_text(sqlite3_stmt* row, const int index) {
+    const auto* text =
+        reinterpret_cast<const char*>(sqlite3_column_text(row, index));
+    return {text ? text : "",
+            static_cast<std::size_t>(sqlite3_column_bytes(row, index))};
+}
+
+// An unquoted empty field is NULL, so empty text is always quoted.
+void write_csv_field(BufferedWriter& out, StringView field) {
+    if (!field.empty() && field.find_first_of(",\"\r\n") == StringView::npos) {
+        out.write(field);
+        return;
+    }
+
+    out.put('"');
+    for (const char c : field) {
+        if (c == '"') {
+            out.put('"');
+        }
+        out.put(c);
+    }
+    out.put('"');
+}
+
+void write_json_string(BufferedWriter& out, StringView text) {
+    constexpr const char* HEX = "0123456789abcdef";
+
+    out.put('"');
+    for (const char c : text) {
+        switch (c) {
+            case '"':
+                out.write("\\\"");
+                break;
+            case '\\':
+                out.write("\\\\");
+                break;
+            case '\n':
+                out.write("\\n");
+                break;
+            case '\r':
+                out.write("\\r");
+                break;
+            case '\t':
+                out.write("\\t");
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out.write("\\u00");
+                    out.put(HEX[(c >> 4) & 0xf]);
+                    out.put(HEX[c & 0xf]);
+                } else {
+                    out.put(c);
+                }
+        }
+    }
+    out.put('"');
+}
+
+[[noreturn]] void malformed(StringView format, const std::size_t record) {
+    throw std::runtime_error("Malformed " + String{format} + " in record " +
+                             std::to_string(record) + ".");
+}
+
+// A field is a view into the mapped file, or into a scratch buffer when it
+// had to be unescaped. A view with no data stands for NULL.
+using Fields = Vector<StringView>;
+
+// RFC 4180: fields separated by commas, records by CRLF or LF, quotes
+// doubled inside quoted fields. An empty field is NULL unless quoted.
+class CsvReader {
+  public:
+    explicit CsvReader(StringView text) : m_text{text} {}
+
+    [[nodiscard]] const Vector<String>& columns() const { return m_columns; }
+
+    bool next(Fields& fields) {
+        if (m_columns.empty()) {
+            if (!read_record(fields)) {
+                return false;
+            }
+            m_columns.assign(fields.begin(), fields.end());
+        }
+
+        return read_record(fields);
+    }
+
+  private:
+    StringView m_text;
+    std::size_t m_pos = 0;
+    std::size_t m_record = 0;
+    Vector<String> m_columns{};
+    Vector<String> m_scratch{};
+
+    bool read_record(Fields& fields) {
+        fields.clear();
+        if (m_pos >= m_text.size()) {
+            return false;
+        }
+        ++m_record;
+
+        while (true) {
+            fields.push_back(read_field(fields.size()));
+
+            if (m_pos >= m_text.size()) {
+                return true;
+            }
+
+            switch (m_text[m_pos]) {
+                case ',':
+                    ++m_pos;
+                    break;
+                case '\r':
+                    ++m_pos;
+                    [[fallthrough]];
+                case '\n':
+                    if (m_pos < m_text.size() && m_text[m_pos] == '\n') {
+                        ++m_pos;
+                    }
+                    return true;
+                default:
+                    malformed("CSV", m_record);
+            }
+        }
+    }
+
+    StringView read_field(const std::size_t index) {
+        if (m_pos >= m_text.size() || m_text[m_pos] != '"') {
+            const std::size_t start = m_pos;
+            m_pos = std::min(m_text.find_first_of(",\r\n", start),
+                             m_text.size());
+            return m_pos > start ? m_text.substr(start, m_pos - start)
+                                 : StringView{};
+        }
+
+        const std::size_t start = ++m_pos;
+        bool escaped = false;
+        while (true) {
+            const std::size_t quote = m_text.find('"', m_pos);
+            if (quote == StringView::npos) {
+                malformed("CSV", m_record);
+            }
+            if (quote + 1 < m_text.size() && m_text[quote + 1] == '"') {
+                escaped = true;
+                m_pos = quote + 2;
+                continue;
+            }
+
+            m_pos = quote + 1;
+            const StringView raw = m_text.substr(start, quote - start);
+            if (!escaped) {
+                return raw;
+            }
+
+            if (m_scratch.size() <= index) {
+                m_scratch.resize(index + 1);
+            }
+            String& field = m_scratch[index];
+            field.clear();
+            for (std::size_t i = 0; i < raw.size(); ++i) {
+                field += raw[i];
+                i += raw[i] == '"';
+            }
+            return field;
+        }
+    }
+};
+
+// One flat JSON object per line. Every line must have the keys of the first
+// one, in the same order, as export_table writes them.
+class JsonlReader {
+  public:
+    explicit JsonlReader(StringView text) : m_text{text} {}
+
+    [[nodiscard]] const Vector<String>& columns() const { return m_columns; }
+
+    bool next(Fields& fields) {
+        fields.clear();
+        skip_space();
+        if (m_pos >= m_text.size()) {
+            return false;
+        }
+        ++m_record;
+
+        expect('{');
+        skip_space();
+        std::size_t index = 0;
+        while (peek() != '}') {
+            if (index > 0) {
+                expect(',');
+                skip_space();
+            }
+            expect_key(index);
+            skip_space();
+            expect(':');
+            skip_space();
+            fields.push_back(read_value(index));
+            skip_space();
+            ++index;
+        }
+        ++m_pos;
+
+        if (index != m_columns.size()) {
+            malformed("JSONL", m_record);
+        }
+        return true;
+    }
+
+  private:
+    StringView m_text;
+    std::size_t m_pos = 0;
+    std::size_t m_record = 0;
+    Vector<String> m_columns{};
+    Vector<String> m_scratch{};
+    String m_key{};
+
+    [[nodiscard]] char peek() const {
+        if (m_pos >= m_text.size()) {
+            malformed("JSONL", m_record);
+        }
+        return m_text[m_pos];
+    }
+
+    void expect(const char c) {
+        if (peek() != c) {
+            malformed("JSONL", m_record);
+        }
+        ++m_pos;
+    }
+
+    void skip_space() {
+        while (m_pos < m_text.size() &&
+               (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' ||
+                m_text[m_pos] == '\r' || m_text[m_pos] == '\n')) {
+            ++m_pos;
+        }
+    }
+
+    void expect_key(const std::size_t index) {
+        const StringView key = read_string(m_key);
+        if (m_record == 1) {
+            m_columns.emplace_back(key);
+        } else if (index >= m_columns.size() || m_columns[index] != key) {
+            malformed("JSONL", m_record);
+        }
+    }
+
+    StringView read_value(const std::size_t index) {
+        if (peek() == '"') {
+            if (m_scratch.size() <= index) {
+                m_scratch.resize(index + 1);
+            }
+            return read_string(m_scratch[index]);
+        }
+
+        const std::size_t start = m_pos;
+        while (m_pos < m_text.size() && m_text[m_pos] != ',' &&
+               m_text[m_pos] != '}' && m_text[m_pos] != ' ' &&
+               m_text[m_pos] != '\n') {
+            ++m_pos;
+        }
+        const StringView token = m_text.substr(start, m_pos - start);
+
+        if (token == "null") {
+            return {};
+        }
+        if (token == "true" || token == "false") {
+            return token == "true" ? "1" : "0";
+        }
+        if (token.empty() || token.find_first_not_of("+-.0123456789eE") !=
+                                 StringView::npos) {
+            malformed("JSONL", m_record);
+        }
+        return token;
+    }
+
+    // Returns a view of the string in the input, or its unescaped copy in
+    // scratch when it has escapes.
+    StringView read_string(String& scratch) {
+        expect('"');
+        const std::size_t start = m_pos;
+        const std::size_t end = m_text.find_first_of("\"\\", m_pos);
+        if (end == StringView::npos) {
+            malformed("JSONL", m_record);
+        }
+        m_pos = end + 1;
+        if (m_text[end] == '"') {
+            return m_text.substr(start, end - start);
+        }
+
+        scratch.assign(m_text.substr(start, end - start));
+        m_pos = end;
+        while (peek() != '"') {
+            const char c = m_text[m_pos++];
+            if (c != '\\') {
+                scratch += c;
+                continue;
+            }
+
+            const char escape = peek();
+            ++m_pos;
+            switch (escape) {
+                case '"':
+                case '\\':
+                case '/':
+                    scratch += escape;
+                    break;
+                case 'b':
+                    scratch += '\b';
+                    break;
+                case 'f':
+                    scratch += '\f';
+                    break;
+                case 'n':
+                    scratch += '\n';
+                    break;
+                case 'r':
+                    scratch += '\r';
+                    break;
+                case 't':
+                    scratch += '\t';
+                    break;
+                case 'u':
+                    append_utf8(scratch, read_code_point());
+                    break;
+                default:
+                    malformed("JSONL", m_record);
+            }
+        }
+        ++m_pos;
+
+        return scratch;
+    }
+
+    char32_t read_hex4() {
+        if (m_pos + 4 > m_text.size()) {
+            malformed("JSONL", m_record);
+        }
+
+        const StringView digits = m_text.substr(m_pos, 4);
+        m_pos += 4;
+
+        char32_t value = 0;
+        for (const char c : digits) {
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                value |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                value |= c - 'A' + 10;
+            } else {
+                malformed("JSONL", m_record);
+            }
+        }
+        return value;
+    }
+
+    char32_t read_code_point() {
+        const char32_t high = read_hex4();
+        if (high < 0xd800 || high > 0xdbff) {
+            return high;
+        }
+
+        // A high surrogate must be followed by an escaped low one.
+        expect('\\');
+        expect('u');
+        const char32_t low = read_hex4();
+        if (low < 0xdc00 || low > 0xdfff) {
+            malformed("JSONL", m_record);
+        }
+        return 0x10000 + ((high - 0xd800) << 10) + (low - 0xdc00);
+    }
+
+    static void append_utf8(String& out, const char32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xc0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xe0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else {
+            out += static_cast<char>(0xf0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        }
+    }
+};
+
+String insert_sql_for(const SQL::Database& db,
+                      StringView table,
+                      const Vector<String>& columns) {
+    Vector<String> known;
+    SQL::Statement info{db, "SELECT name FROM pragma_table_info(?)"};
+    info.bind(1, String{table});
+    while (info.executeStep()) {
+        known.push_back(info.getColumn(0).getString());
+    }
+
+    String sql = "INSERT INTO " + String{table} + " (";
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        if (std::ranges::find(known, columns[i]) == known.end()) {
+            throw std::runtime_error("Unknown column: " + columns[i]);
+        }
+        sql += (i == 0 ? "" : ", ") + columns[i];
+    }
+    sql += ") VALUES (";
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        sql += (i == 0) ? "?" : ", ?";
+    }
+    sql += ")";
+
+    return sql;
+}
+
+template <typename Reader>
+std::size_t import_rows(Connection& connection,
+                        StringView table,
+                        Reader& reader,
+                        const std::size_t batch_size) {
+    Fields fields;
+    if (!reader.next(fields)) {
+        return 0;
+    }
+
+    const auto& columns = reader.columns();
+    SQL::Statement insert{connection.db(),
+                          insert_sql_for(connection.db(), table, columns)};
+
+    std::size_t rows = 0;
+    std::optional<UnitOfWork> work{};
+    do {
+        if (fields.size() != columns.size()) {
+            throw std::runtime_error("Row " + std::to_string(rows + 1) +
+                                     " does not match the columns.");
+        }
+        if (!work) {
+            work.emplace(connection);
+        }
+
+        for (std::size_t i = 0; i < fields.size(); ++i) {
+            const int index = static_cast<int>(i) + 1;
+            if (fields[i].data()) {
+                ColumnCodec<StringView>::bind(insert, index, fields[i]);
+            } else {
+                insert.bind(index);
+            }
+        }
+        insert.exec();
+        insert.reset();
+
+        if (++rows % batch_size == 0) {
+            work->commit();
+            work.reset();
+        }
+    } while (reader.next(fields));
+
+    if (work) {
+        work->commit();
+    }
+
+    return rows;
+}
+}  // namespace
+
+std::optional<TransferFormat> transfer_format_of(const fs::path& path) {
+    const auto extension = path.extension();
+    if (extension == ".csv") {
+        return TransferFormat::Csv;
+    }
+    if (extension == ".jsonl") {
+        return TransferFormat::Jsonl;
+    }
+
+    return std::nullopt;
+}
+
+double TransferStats::rows_per_second() const {
+    const double seconds = sch::duration<double>(elapsed).count();
+    return seconds > 0 ? static_cast<double>(rows) / seconds : 0;
+}
+
+TransferStats export_table(Connection& connection,
+                           StringView table,
+                           const TransferFormat format,
+                           const fs::path& path) {
+    check_table(table);
+    const auto start = sch::steady_clock::now();
+    // Keeps other threads' transactions out of the file until it is whole.
+    const auto lock = connection.lock();
+
+    SQL::Statement query{connection.db(),
+                         "SELECT * FROM " + String{table} + " ORDER BY rowid"};
+    sqlite3_stmt* row = query.getPreparedStatement();
+    const int columns = query.getColumnCount();
+
+    // Each JSONL line repeats the keys, so they are escaped once here.
+    Vector<String> keys;
+    for (int i = 0; i < columns; ++i) {
+        keys.push_back((i == 0 ? "{\"" : ",\"") +
+                       String{query.getColumnName(i)} + "\":");
+    }
+
+    BufferedWriter out{path};
+    if (format == TransferFormat::Csv) {
+        for (int i = 0; i < columns; ++i) {
+            if (i > 0) {
+                out.put(',');
+            }
+            write_csv_field(out, query.getColumnName(i));
+        }
+        out.put('\n');
+    }
+
+    std::size_t rows = 0;
+    while (query.executeStep()) {
+        for (int i = 0; i < columns; ++i) {
+            const int type = sqlite3_column_type(row, i);
+
+            if (format == TransferFormat::Csv) {
+                if (i > 0) {
+                    out.put(',');
+                }
+                if (type != SQLITE_NULL) {
+                    write_csv_field(out, column_text(row, i));
+                }
+            } else {
+                out.write(keys[i]);
+                if (type == SQLITE_NULL) {
+                    out.write("null");
+                } else if (type == SQLITE_INTEGER || type == SQLITE_FLOAT) {
+                    out.write(column_text(row, i));
+                } else {
+                    write_json_string(out, column_text(row, i));
+                }
+            }
+        }
+        out.write(format == TransferFormat::Csv ? "\n" : "}\n");
+        ++rows;
+    }
+    out.close();
+
+    return {rows, sch::steady_clock::now() - start};
+}
+
+TransferStats import_table(Connection& connection,
+                           StringView table,
+                           const TransferFormat format,
+                           const fs::path& path,
+                           const std::size_t batch_size) {
+    check_table(table);
+    const auto start = sch::steady_clock::now();
+
+    const MappedFile file{path};
+    std::size_t rows = 0;
+    if (format == TransferFormat::Csv) {
+        CsvReader reader{file.view()};
+        rows = import_rows(connection, table, reader, batch_size);
+    } else {
+        JsonlReader reader{file.view()};
+        rows = import_rows(connection, table, reader, batch_size);
+    }
+
+    return {rows, sch::steady_clock::now() - start};
+}
+}  // namespace twodocore
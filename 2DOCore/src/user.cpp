@@ -1,6 +1,7 @@
 #include "2DOCore/user.hpp"
 
 #include <regex>
+#include <utility>
 
 #include "SQLiteCpp/Database.h"
 #include "SQLiteCpp/Statement.h"
@@ -32,75 +33,124 @@ Role User::stor(const String& role_str) const {
     }
 }
 
-UserDb::UserDb(const fs::path& db_filepath)
-    : m_db{db_filepath, SQL::OPEN_READWRITE} {
-    if (!m_db.tableExists("users")) {
-        SQL::Statement query{
-            m_db,
-            "CREATE TABLE IF NOT EXISTS users ("
-            "user_id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, "
-            "username VARCHAR(20) NOT NULL, "
-            "role BOOLEAN NOT NULL, "
-            "password VARCHAR(20) NOT NULL)"};
-
-        query.exec();
-        if (!query.isDone())
-            throw std::runtime_error("Failure creating user table.");
+void ColumnCodec<Role>::bind(SQL::Statement& query,
+                             const int index,
+                             const Role value) {
+    query.bindNoCopy(index, value == Role::Admin ? "Admin" : "User");
+}
+
+void ColumnCodec<Role>::read(sqlite3_stmt* row, const int index, Role& value) {
+    const StringView name{
+        reinterpret_cast<const char*>(sqlite3_column_text(row, index)),
+        static_cast<std::size_t>(sqlite3_column_bytes(row, index))};
+
+    if (name == "Admin") {
+        value = Role::Admin;
+    } else if (name == "User") {
+        value = Role::User;
+    } else {
+        throw std::logic_error("Invalid role string!");
     }
 }
 
+UserDb::UserDb(std::shared_ptr<Connection> connection)
+    : m_connection{std::move(connection)},
+      m_statements{std::make_unique<StatementCache>(*m_connection)},
+      m_cache{std::make_unique<IdentityMap<User>>()},
+      m_subscription{
+          watch_table(*m_connection, Schema<User>::table, *m_cache)} {}
+
 User UserDb::get_object(const unsigned int id) const {
-    SQL::Statement query{m_db, "SELECT * FROM users WHERE user_id = ?"};
-    query.bind(1, id);
+    m_connection->await_own_writes();
+    if (auto user = m_cache->find(id)) {
+        return std::move(user.value());
+    }
+
+    const auto generation = m_cache->generation();
+    auto query =
+        m_statements->acquire(select_sql<User, " WHERE user_id = ?">());
+    query->bind(1, id);
 
-    query.executeStep();
+    query->executeStep();
 
-    return User{(unsigned)query.getColumn(0).getInt(),
-                query.getColumn(1).getString(), query.getColumn(2).getString(),
-                query.getColumn(3).getString()};
+    User user = read_row<User>(*query);
+    m_cache->fill(id, user, generation);
+
+    return user;
 }
 
 std::optional<User> UserDb::find_object_by_unique_column(
-    const String& column_value) const {
-    SQL::Statement query{m_db, "SELECT * FROM users WHERE username = ?"};
-    query.bind(1, column_value);
+    StringView column_value) const {
+    m_connection->await_own_writes();
+    auto query =
+        m_statements->acquire(select_sql<User, " WHERE username = ?">());
+    ColumnCodec<StringView>::bind(*query, 1, column_value);
 
     try {
-        if (!query.executeStep()) {
+        if (!query->executeStep()) {
             return std::nullopt;
         }
     } catch (const SQL::Exception& e) {
-        if (query.hasRow()) {
+        if (query->hasRow()) {
             throw e;
         }
     }
 
-    return User{(unsigned)query.getColumn(0).getInt(),
-                query.getColumn(1).getString(), query.getColumn(2).getString(),
-                query.getColumn(3).getString()};
+    return read_row<User>(*query);
 };
 
 Vector<User> UserDb::get_all_objects() const {
-    SQL::Statement query{m_db, "SELECT * FROM users"};
+    m_connection->await_own_writes();
+    if (auto users = m_cache->find_all()) {
+        return std::move(users.value());
+    }
+
+    const auto generation = m_cache->generation();
+    auto query = m_statements->acquire(select_sql<User>());
 
     Vector<User> users;
-    while (query.executeStep()) {
-        users.push_back(User{(unsigned)query.getColumn(0).getInt(),
-                             query.getColumn(1).getString(),
-                             query.getColumn(2).getString(),
-                             query.getColumn(3).getString()});
+    while (query->executeStep()) {
+        users.push_back(read_row<User>(*query));
     }
+    m_cache->fill_all(users, generation,
+                      [](const User& user) { return user.id(); });
 
     return users;
 }
 
+PmrVector<User> UserDb::get_all_objects(
+    std::pmr::memory_resource* resource) const {
+    m_connection->await_own_writes();
+    auto query = m_statements->acquire(select_sql<User>());
+
+    PmrVector<User> users{resource};
+    while (query->executeStep()) {
+        users.push_back(read_row<User>(*query));
+    }
+
+    return users;
+}
+
+Cursor<User> UserDb::stream_all_objects(const unsigned int after_id,
+                                        const int limit) const {
+    m_connection->await_own_writes();
+    auto query = std::make_unique<SQL::Statement>(
+        m_connection->db(),
+        select_sql<User, " WHERE user_id > ? ORDER BY user_id LIMIT ?">());
+    query->bind(1, after_id);
+    query->bind(2, limit);
+
+    return Cursor<User>{std::move(query), &read_row<User>};
+}
+
 bool UserDb::is_table_empty() const {
+    m_connection->await_own_writes();
     int count = 0;
 
     try {
-        SQLite::Statement query(m_db, "SELECT COUNT(*) FROM users");
-        if (query.executeStep()) {
-            count = query.getColumn(0).getInt();
+        auto query = m_statements->acquire("SELECT COUNT(*) FROM users");
+        if (query->executeStep()) {
+            count = query->getColumn(0).getInt();
         }
     } catch (SQLite::Exception& e) {
         return true;
@@ -109,55 +159,36 @@ bool UserDb::is_table_empty() const {
     return count == 0;
 }
 
-void UserDb::add_object(User& user) {
-    SQL::Statement query{
-        m_db, "INSERT INTO users (username, role, password) VALUES (?, ?, ?)"};
-    query.bind(1, user.username());
-    query.bind(2, user.role<String>());
-    query.bind(3, user.password());
-
-    query.exec();
-
-    query = SQL::Statement{
-        m_db, "SELECT user_id FROM users ORDER BY user_id DESC LIMIT 1"};
+unsigned int UserDb::add_object(User& user) const {
+    const unsigned int id = add_object(std::as_const(user));
+    user.set_id(id);
 
-    query.executeStep();
-
-    user.set_id(std::stoi(query.getColumn(0)));
+    return id;
 }
 
-void UserDb::add_object(const User& user) const {
-    SQL::Statement query{
-        m_db, "INSERT INTO users (username, role, password) VALUES (?, ?, ?)"};
-    query.bind(1, user.username());
-    query.bind(2, user.role<String>());
-    query.bind(3, user.password());
-
-    query.exec();
+unsigned int UserDb::add_object(const User& user) const {
+    auto query = m_statements->acquire(insert_sql<User>());
+    bind_columns(*query, user);
 
-    query = SQL::Statement{
-        m_db, "SELECT user_id FROM users ORDER BY user_id DESC LIMIT 1"};
+    query->exec();
 
-    query.executeStep();
+    return static_cast<unsigned int>(m_connection->db().getLastInsertRowid());
 }
 
 void UserDb::update_object(const User& user) const {
-    SQL::Statement query{m_db,
-                         "UPDATE users SET username = ?, role = ?, "
-                         "password = ? WHERE user_id = ?"};
-    query.bind(1, user.username());
-    query.bind(2, user.role<String>());
-    query.bind(3, user.password());
-    query.bind(4, std::to_string(user.id()));
-
-    query.exec();
+    auto query = m_statements->acquire(update_sql<User>());
+    bind_columns_and_key(*query, user);
+
+    query->exec();
+    m_cache->put(user.id(), user);
 }
 
 void UserDb::delete_object(const unsigned int id) const {
-    SQL::Statement query{m_db, "DELETE FROM users WHERE user_id = ?"};
-    query.bind(1, std::to_string(id));
+    auto query = m_statements->acquire("DELETE FROM users WHERE user_id = ?");
+    query->bind(1, id);
 
-    query.exec();
+    query->exec();
+    m_cache->erase(id);
 }
 
 tdu::Result<void, AuthErr> AuthenticationManager::username_validation(
@@ -203,13 +234,4 @@ tdu::Result<void, AuthErr> AuthenticationManager::password_validation(
 bool AuthenticationManager::is_in_db(const String& username) const {
     return (m_user_db->find_object_by_unique_column(username)) ? true : false;
 };
-
-void clear_all_db_data(const fs::path& filepath,
-                       const Vector<String>& table_names) {
-    SQLite::Database db{filepath, SQL::OPEN_READWRITE};
-
-    for (const auto& table_name : table_names) {
-        db.exec("DELETE FROM " + table_name);
-    }
-}
 }  // namespace twodocore
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "2DOCore/wipe.hpp"
+
+#include <SQLiteCpp/Exception.h>
+#include <SQLiteCpp/Statement.h>
+
+#include <stdexcept>
+
+namespace twodocore {
+namespace {
+int64_t database_bytes(SQL::Database& db) {
+    SQL::Statement query{db,
+                         "SELECT page_count * page_size "
+                         "FROM pragma_page_count(), pragma_page_size()"};
+    query.executeStep();
+
+    return query.getColumn(0).getInt64();
+}
+
+// What creates table again as it is now: the table first, then its
+// indexes and triggers.
+Vector<String> schema_of(SQL::Database& db, const String& table) {
+    SQL::Statement query{db,
+                         "SELECT sql FROM sqlite_master "
+                         "WHERE tbl_name = ? AND sql IS NOT NULL "
+                         "ORDER BY CASE type WHEN 'table' THEN 0 "
+                         "WHEN 'index' THEN 1 ELSE 2 END"};
+    query.bind(1, table);
+
+    Vector<String> statements;
+    while (query.executeStep()) {
+        statements.push_back(query.getColumn(0).getString());
+    }
+    if (statements.empty()) {
+        throw std::runtime_error("Unknown table: " + table);
+    }
+
+    return statements;
+}
+
+// External-content full-text tables that index table.
+Vector<String> fts_tables_over(SQL::Database& db, const String& table) {
+    SQL::Statement query{db,
+                         "SELECT name FROM sqlite_master "
+                         "WHERE type = 'table' AND sql LIKE "
+                         "'CREATE VIRTUAL TABLE % USING fts5(%' "
+                         "AND sql LIKE ?"};
+    query.bind(1, "%content='" + table + "'%");
+
+    Vector<String> names;
+    while (query.executeStep()) {
+        names.push_back(query.getColumn(0).getString());
+    }
+
+    return names;
+}
+}  // namespace
+
+WipeStats clear_all_db_data(Connection& connection,
+                            const Vector<String>& table_names,
+                            const WipeProgressListener& listener) {
+    // VACUUM included, as it cannot run inside another thread's transaction.
+    const auto lock = connection.lock();
+    SQL::Database& db = connection.db();
+    const std::size_t total = table_names.size() + 1;
+    const auto report = [&](String step, const std::size_t done) {
+        if (listener) {
+            listener(WipeProgress{std::move(step), done, total});
+        }
+    };
+
+    WipeStats stats{database_bytes(db), 0, {}};
+    const auto start = sch::steady_clock::now();
+
+    try {
+        UnitOfWork work{connection};
+
+        for (std::size_t i = 0; i < table_names.size(); ++i) {
+            const String& table = table_names[i];
+            report("Emptying " + table, i);
+
+            const auto schema = schema_of(db, table);
+            // Dropping frees whole pages without visiting a row; it also
+            // drops the table's sqlite_sequence entry.
+            db.exec("DROP TABLE " + table);
+            for (const auto& statement : schema) {
+                db.exec(statement);
+            }
+            for (const auto& fts : fts_tables_over(db, table)) {
+                db.exec("INSERT INTO " + fts + " (" + fts +
+                        ") VALUES ('delete-all')");
+            }
+        }
+
+        work.commit();
+    } catch (...) {
+        connection.notify_reset();
+        throw;
+    }
+    // Dropped rows never reach the update hook.
+    connection.notify_reset();
+
+    report("Reclaiming free space", table_names.size());
+    try {
+        db.exec("VACUUM");
+        db.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+    } catch (const SQL::Exception&) {
+        // The pages stay on the free list and are reused by later inserts.
+    }
+
+    stats.bytes_after = database_bytes(db);
+    stats.elapsed = sch::steady_clock::now() - start;
+    report("Done", total);
+
+    return stats;
+}
+}  // namespace twodocore
@@ -0,0 +1,152 @@
+#include "2DOCore/write_queue.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace twodocore {
+namespace {
+std::atomic<std::uint64_t> next_queue_id{1};
+
+// For each queue this thread wrote to, how many writes must be applied
+// before its own last one is.
+thread_local HashMap<std::uint64_t, std::uint64_t> awaited_writes{};
+}  // namespace
+
+WriteQueue::WriteQueue(std::shared_ptr<Connection> connection,
+                       WriteErrorListener on_error,
+                       const std::size_t capacity)
+    : m_connection{std::move(connection)},
+      m_on_error{std::move(on_error)},
+      m_id{next_queue_id.fetch_add(1, std::memory_order_relaxed)},
+      m_queue{capacity} {
+    const WriteQueue* none = nullptr;
+    if (!m_connection->m_write_queue.compare_exchange_strong(none, this)) {
+        throw std::runtime_error("The connection already has a write queue.");
+    }
+
+    m_thread = std::jthread{[this](std::stop_token stop) { run(stop); }};
+}
+
+WriteQueue::~WriteQueue() {
+    m_thread.request_stop();
+    m_signal.fetch_add(1, std::memory_order_release);
+    m_signal.notify_one();
+    m_thread.join();
+
+    m_connection->m_write_queue.store(nullptr, std::memory_order_release);
+}
+
+WriteTicket WriteQueue::submit(std::function<void()> write) {
+    PendingWrite pending{std::move(write), {}};
+    WriteTicket ticket{pending.committed.get_future().share()};
+
+    std::optional<std::size_t> position;
+    while (true) {
+        const std::uint64_t taken = m_taken.load(std::memory_order_acquire);
+        if ((position = m_queue.try_push(std::move(pending)))) {
+            break;
+        }
+        // Full; sleeps until the writer takes some off.
+        m_taken.wait(taken, std::memory_order_acquire);
+    }
+    awaited_writes.insert_or_assign(m_id, *position + 1);
+
+    m_signal.fetch_add(1, std::memory_order_release);
+    m_signal.notify_one();
+
+    return ticket;
+}
+
+WriteTicket WriteQueue::flush() {
+    // Groups commit in queue order, so once this one is in every write
+    // before it is too.
+    return submit([] {});
+}
+
+void WriteQueue::sync() const {
+    const auto it = awaited_writes.find(m_id);
+    if (it == awaited_writes.end()) {
+        return;
+    }
+
+    std::uint64_t applied = m_applied.load(std::memory_order_acquire);
+    while (applied < it->second) {
+        m_applied.wait(applied, std::memory_order_acquire);
+        applied = m_applied.load(std::memory_order_acquire);
+    }
+    awaited_writes.erase(it);
+}
+
+WriteQueueStats WriteQueue::stats() const {
+    return WriteQueueStats{m_applied.load(std::memory_order_relaxed),
+                           m_commits.load(std::memory_order_relaxed)};
+}
+
+void WriteQueue::run(std::stop_token stop) {
+    Vector<PendingWrite> group;
+    group.reserve(m_queue.capacity());
+
+    while (true) {
+        const std::uint64_t seen = m_signal.load(std::memory_order_acquire);
+
+        while (group.size() < m_queue.capacity()) {
+            auto pending = m_queue.try_pop();
+            if (!pending) {
+                break;
+            }
+            group.push_back(std::move(*pending));
+        }
+
+        if (!group.empty()) {
+            m_taken.fetch_add(1, std::memory_order_release);
+            m_taken.notify_all();
+            commit_group(group);
+            group.clear();
+        } else if (stop.stop_requested()) {
+            return;
+        } else {
+            m_signal.wait(seen, std::memory_order_acquire);
+        }
+    }
+}
+
+void WriteQueue::commit_group(Vector<PendingWrite>& group) {
+    Vector<std::exception_ptr> errors(group.size());
+
+    try {
+        UnitOfWork work{*m_connection};
+        for (std::size_t i = 0; i < group.size(); ++i) {
+            try {
+                UnitOfWork single{*m_connection};
+                group[i].write();
+                single.commit();
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+
+        work.commit();
+        m_commits.fetch_add(1, std::memory_order_relaxed);
+    } catch (...) {
+        // The group could not be committed, so none of it was.
+        for (auto& error : errors) {
+            error = error ? error : std::current_exception();
+        }
+    }
+
+    // Only now, so a reader on another connection finds them too.
+    m_applied.fetch_add(group.size(), std::memory_order_release);
+    m_applied.notify_all();
+
+    for (std::size_t i = 0; i < group.size(); ++i) {
+        if (errors[i]) {
+            if (m_on_error) {
+                m_on_error(errors[i]);
+            }
+            group[i].committed.set_exception(errors[i]);
+        } else {
+            group[i].committed.set_value();
+        }
+    }
+}
+}  // namespace twodocore
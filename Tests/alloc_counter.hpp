@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+namespace alloc_counter {
+// Number of global operator new calls made so far by this test binary.
+[[nodiscard]] std::size_t count() noexcept;
+}  // namespace alloc_counter
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+#include <gtest/gtest.h>
+
+#include <2DOApp/app.hpp>
+#include <2DOCore/database.hpp>
+#include <2DOCore/task.hpp>
+#include <2DOCore/user.hpp>
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+#include "alloc_counter.hpp"
+
+namespace tdc = twodocore;
+namespace tdu = twodoutils;
+
+constexpr unsigned int ROWS = 100;
+
+// Both strings are longer than the small string buffer, so each one costs
+// exactly one allocation when a row is decoded.
+const String LONG_TOPIC = "A topic longer than the small buffer";
+const String LONG_CONTENT = "Content that is also longer than the small buffer";
+
+struct AllocationTest : testing::Test {
+    std::shared_ptr<tdc::Connection> connection =
+        std::make_shared<tdc::Connection>(":memory:");
+    tdc::TaskDb task_db{connection};
+
+    void SetUp() override {
+        const tdc::Task task{LONG_TOPIC, LONG_CONTENT,
+                             tdu::get_current_timestamp(),
+                             tdu::get_current_timestamp(1),
+                             1,
+                             2,
+                             false};
+        task_db.add_objects(Vector<tdc::Task>(ROWS, task));
+    }
+};
+
+TEST_F(AllocationTest, DecodedTaskRow) {
+    auto tasks =
+        task_db.stream_all_objects<tdc::TaskDb::IdType::Executor>(1);
+
+    std::size_t rows = 0;
+    std::size_t length = 0;
+    const std::size_t before = alloc_counter::count();
+    for (const auto& task : tasks) {
+        length += task.topic().size() + task.content().size();
+        ++rows;
+    }
+    const std::size_t allocations = alloc_counter::count() - before;
+
+    ASSERT_EQ(rows, ROWS);
+    EXPECT_EQ(length, ROWS * (LONG_TOPIC.size() + LONG_CONTENT.size()));
+    EXPECT_EQ(allocations, 2 * ROWS);
+}
+
+TEST_F(AllocationTest, DecodedSummaryRow) {
+    auto summaries =
+        task_db.stream_all_summaries<tdc::TaskDb::IdType::Owner>(2);
+
+    std::size_t rows = 0;
+    const std::size_t before = alloc_counter::count();
+    for (const auto& summary : summaries) {
+        rows += summary.topic() == LONG_TOPIC;
+    }
+    const std::size_t allocations = alloc_counter::count() - before;
+
+    ASSERT_EQ(rows, ROWS);
+    EXPECT_EQ(allocations, ROWS);
+}
+
+TEST_F(AllocationTest, RenderedTaskLine) {
+    const tdc::TaskSummary summary{1, LONG_TOPIC, tdu::get_current_timestamp(),
+                                   2, false};
+
+    std::size_t length = 0;
+    const std::size_t before = alloc_counter::count();
+    for (unsigned int i = 1; i <= ROWS; ++i) {
+        length += twodo::format_task_line(i, summary).size();
+    }
+    const std::size_t allocations = alloc_counter::count() - before;
+
+    EXPECT_GT(length, ROWS * LONG_TOPIC.size());
+    EXPECT_EQ(allocations, ROWS);
+}
+
+TEST_F(AllocationTest, ArenaBackedTaskList) {
+    // Prepares and caches the statement outside the measured call.
+    const auto warm_up =
+        task_db.get_all_objects<tdc::TaskDb::IdType::Executor>(1);
+
+    static Array<std::byte, 256 * 1024> buffer;
+    std::pmr::monotonic_buffer_resource arena{
+        buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+
+    const std::size_t before = alloc_counter::count();
+    const auto tasks =
+        task_db.get_all_objects<tdc::TaskDb::IdType::Executor>(1, &arena);
+    const std::size_t allocations = alloc_counter::count() - before;
+
+    ASSERT_EQ(tasks.size(), ROWS);
+    EXPECT_EQ(tasks.front().content(), LONG_CONTENT);
+    EXPECT_TRUE(std::equal(tasks.begin(), tasks.end(), warm_up.begin()));
+    EXPECT_EQ(allocations, 0);
+}
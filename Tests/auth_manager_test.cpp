@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 
+#include <2DOCore/database.hpp>
 #include <2DOCore/user.hpp>
 #include <Utils/type.hpp>
 
@@ -10,7 +11,8 @@ namespace tdc = twodocore;
 constexpr StringView TEST_DB_PATH = ":memory:";
 
 TEST(AuthTest, CheckAuthManagerFunctionalities) {
-    const auto udb = std::make_shared<tdc::UserDb>(TEST_DB_PATH);
+    const auto udb = std::make_shared<tdc::UserDb>(
+        std::make_shared<tdc::Connection>(TEST_DB_PATH));
     const tdc::AuthenticationManager am{udb};
 
     EXPECT_FALSE(am.username_validation(""));
@@ -0,0 +1,582 @@
+#include <atomic>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/Transaction.h>
+#include <gtest/gtest.h>
+#include <sqlite3.h>
+
+#include <2DOCore/archive.hpp>
+#include <2DOCore/backup.hpp>
+#include <2DOCore/database.hpp>
+#include <2DOCore/pool.hpp>
+#include <2DOCore/scheduler.hpp>
+#include <2DOCore/task.hpp>
+#include <2DOCore/transfer.hpp>
+#include <2DOCore/wipe.hpp>
+#include <2DOCore/write_queue.hpp>
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+#include "alloc_counter.hpp"
+
+namespace tdc = twodocore;
+namespace tdu = twodoutils;
+
+constexpr unsigned int BENCH_ROWS = 100'000;
+constexpr unsigned int BENCH_CALLS = 10'000;
+
+struct BenchmarkTest : testing::Test {
+    fs::path db_path = fs::temp_directory_path() / "2do_bench.db3";
+    std::shared_ptr<tdc::Connection> connection = nullptr;
+
+    void SetUp() override {
+        remove_db_files();
+        SQL::Database{db_path, SQL::OPEN_READWRITE | SQL::OPEN_CREATE};
+        connection = std::make_shared<tdc::Connection>(db_path);
+    }
+
+    void TearDown() override {
+        connection.reset();
+        remove_db_files();
+    }
+
+    void remove_db_files() const {
+        fs::remove(db_path);
+        fs::remove(fs::path{db_path} += "-wal");
+        fs::remove(fs::path{db_path} += "-shm");
+    }
+
+    void fill_tasks(SQL::Database& db, const unsigned int rows) const {
+        SQL::Transaction transaction{db};
+        SQL::Statement query{
+            db,
+            "INSERT INTO tasks (topic, content, start_date, deadline, "
+            "executor_id, owner_id, is_done) VALUES (?, ?, ?, ?, ?, ?, ?)"};
+
+        const auto now = tdu::to_epoch_minutes(tdu::get_current_timestamp());
+        for (unsigned int i = 0; i < rows; ++i) {
+            query.bind(1, "Topic");
+            query.bind(2, "Some content to do.");
+            query.bind(3, now);
+            query.bind(4, now);
+            query.bind(5, i % 100);
+            query.bind(6, i % 10);
+            query.bind(7, 0);
+            query.exec();
+            query.reset();
+        }
+
+        transaction.commit();
+    }
+
+    static void report(StringView name,
+                       const NanoSeconds elapsed,
+                       const unsigned int calls) {
+        std::cout << std::format("[ BENCH    ] {}: {:.1f} ns/call\n", name,
+                                 static_cast<double>(elapsed.count()) / calls);
+    }
+};
+
+TEST_F(BenchmarkTest, TaskGetObjectStatementCache) {
+    const tdc::TaskDb task_db{connection};
+    SQL::Database& db = connection->db();
+    fill_tasks(db, BENCH_ROWS);
+
+    const auto uncached = tdu::speed_test([&] {
+        for (unsigned int i = 1; i <= BENCH_CALLS; ++i) {
+            SQL::Statement query{db, "SELECT * FROM tasks WHERE task_id = ?"};
+            query.bind(1, i * (BENCH_ROWS / BENCH_CALLS));
+            query.executeStep();
+
+            const tdc::Task task{
+                (unsigned)query.getColumn(0).getInt(),
+                query.getColumn(1).getString(),
+                query.getColumn(2).getString(),
+                tdu::from_epoch_minutes(query.getColumn(3).getInt64()),
+                tdu::from_epoch_minutes(query.getColumn(4).getInt64()),
+                (unsigned)query.getColumn(5).getInt(),
+                (unsigned)query.getColumn(6).getInt(),
+                query.getColumn(7).getInt() != 0};
+        }
+    });
+
+    const auto cached = tdu::speed_test([&] {
+        for (unsigned int i = 1; i <= BENCH_CALLS; ++i) {
+            const auto task =
+                task_db.get_object(i * (BENCH_ROWS / BENCH_CALLS));
+        }
+    });
+
+    report("TaskDb::get_object (fresh statement)", uncached, BENCH_CALLS);
+    report("TaskDb::get_object (cached statement)", cached, BENCH_CALLS);
+
+    EXPECT_LT(cached.count(), uncached.count());
+}
+
+TEST_F(BenchmarkTest, TaskBatchInsertThroughput) {
+    const tdc::TaskDb task_db{connection};
+
+    const tdc::Task task{"Topic",
+                         "Some content to do.",
+                         tdu::get_current_timestamp(),
+                         tdu::get_current_timestamp(1),
+                         1,
+                         2,
+                         false};
+
+    double single_rows_per_sec = 0;
+    double batched_rows_per_sec = 0;
+    for (const std::size_t batch_size : {1, 100, 10'000}) {
+        // Every batch of one pays its own commit, so keep that run short.
+        const std::size_t batches =
+            (batch_size == 1) ? 200 : 10'000 / batch_size;
+        const Vector<tdc::Task> batch(batch_size, task);
+
+        const auto elapsed = tdu::speed_test([&] {
+            for (std::size_t i = 0; i < batches; ++i) {
+                const auto ids = task_db.add_objects(batch);
+            }
+        });
+
+        const double rows_per_sec = static_cast<double>(batches * batch_size) /
+                                    sch::duration<double>(elapsed).count();
+        std::cout << std::format(
+            "[ BENCH    ] TaskDb::add_objects (batch of {}): {:.0f} rows/s\n",
+            batch_size, rows_per_sec);
+
+        if (batch_size == 1) {
+            single_rows_per_sec = rows_per_sec;
+        } else {
+            batched_rows_per_sec = rows_per_sec;
+        }
+    }
+
+    EXPECT_GT(batched_rows_per_sec, single_rows_per_sec);
+}
+
+TEST_F(BenchmarkTest, CommitLatencyPerConnectionProfile) {
+    connection.reset();
+
+    constexpr unsigned int COMMITS = 200;
+    HashMap<String, NanoSeconds> latencies;
+    for (const auto& profile : tdc::CONNECTION_PROFILES) {
+        remove_db_files();
+        SQL::Database{db_path, SQL::OPEN_READWRITE | SQL::OPEN_CREATE};
+
+        const tdc::TaskDb task_db{
+            std::make_shared<tdc::Connection>(db_path, profile)};
+        tdc::Task task{"Topic",
+                       "Some content to do.",
+                       tdu::get_current_timestamp(),
+                       tdu::get_current_timestamp(1),
+                       1,
+                       2,
+                       false};
+        task_db.add_object(task);
+
+        const auto elapsed = tdu::speed_test([&] {
+            for (unsigned int i = 0; i < COMMITS; ++i) {
+                task.set_is_done(i % 2);
+                task_db.update_object(task);
+            }
+        });
+
+        report(std::format("Commit latency ({} profile)", profile.name),
+               elapsed, COMMITS);
+        latencies.insert({String{profile.name}, elapsed});
+    }
+
+    EXPECT_LT(latencies["fast"].count(), latencies["durable"].count());
+}
+
+TEST_F(BenchmarkTest, TaskSearchLatency) {
+    constexpr unsigned int VOCABULARY_SIZE = 5'000;
+    constexpr unsigned int SEARCH_MESSAGES = 10 * BENCH_ROWS;
+    const auto word_of = [](const unsigned int row, const unsigned int k) {
+        return (row * 7'919 + k * 104'729) % VOCABULARY_SIZE;
+    };
+
+    const tdc::TaskDb task_db{connection};
+    SQL::Database& db = connection->db();
+    fill_tasks(db, BENCH_ROWS);
+
+    {
+        SQL::Transaction transaction{db};
+        SQL::Statement query{db,
+                             "INSERT INTO messages (task_id, sender_name, "
+                             "content, timestamp) VALUES (?, ?, ?, ?)"};
+
+        // Eight words per message out of a vocabulary of VOCABULARY_SIZE,
+        // ten messages per task.
+        const auto now = tdu::to_epoch_minutes(tdu::get_current_timestamp());
+        for (unsigned int i = 0; i < SEARCH_MESSAGES; ++i) {
+            String content;
+            for (unsigned int k = 0; k < 8; ++k) {
+                content += std::format("word{} ", word_of(i, k));
+            }
+
+            query.bind(1, i % BENCH_ROWS + 1);
+            query.bind(2, "someguy");
+            query.bind(3, content);
+            query.bind(4, now);
+            query.exec();
+            query.reset();
+        }
+
+        transaction.commit();
+    }
+
+    constexpr unsigned int QUERIES = 200;
+    std::size_t hits = 0;
+    const auto elapsed = tdu::speed_test([&] {
+        for (unsigned int i = 0; i < QUERIES; ++i) {
+            // Owners run from 0 to 9.
+            hits += task_db
+                        .search(std::format("word{} word{}", word_of(i, 0),
+                                            word_of(i, 1)),
+                                i % 10, 20)
+                        .size();
+        }
+    });
+
+    report("TaskDb::search", elapsed, QUERIES);
+    EXPECT_GT(hits, 0);
+}
+
+TEST_F(BenchmarkTest, TaskTransferThroughput) {
+    fill_tasks(connection->db(), BENCH_ROWS);
+
+    for (const StringView extension : {".csv", ".jsonl"}) {
+        const fs::path path =
+            fs::temp_directory_path() / ("2do_bench" + String{extension});
+        const auto format = *tdc::transfer_format_of(path);
+
+        const auto exported =
+            tdc::export_table(*connection, "tasks", format, path);
+        connection->db().exec("DELETE FROM tasks");
+        const auto imported =
+            tdc::import_table(*connection, "tasks", format, path);
+        fs::remove(path);
+
+        std::cout << std::format(
+            "[ BENCH    ] export/import tasks ({}): {:.0f} / {:.0f} rows/s\n",
+            extension, exported.rows_per_second(),
+            imported.rows_per_second());
+        EXPECT_EQ(imported.rows, BENCH_ROWS);
+    }
+}
+
+TEST_F(BenchmarkTest, OnlineBackupStepLatency) {
+    fill_tasks(connection->db(), BENCH_ROWS);
+    const fs::path folder = fs::temp_directory_path() / "2do_bench_snapshots";
+    fs::remove_all(folder);
+    fs::create_directories(folder);
+
+    // A step is the longest a user action can wait on a running backup.
+    unsigned int steps = 0;
+    NanoSeconds longest{0};
+    const auto elapsed = tdu::speed_test([&] {
+        tdc::OnlineBackup backup{*connection, folder / "step.db3"};
+        bool done = false;
+        while (!done) {
+            const auto step = tdu::speed_test([&] { done = backup.step(); });
+            longest = std::max(longest, step);
+            ++steps;
+        }
+    });
+
+    report(std::format("OnlineBackup::step ({} pages)", tdc::BACKUP_STEP_PAGES),
+           elapsed, steps);
+    report("OnlineBackup::step (longest)", longest, 1);
+
+    tdc::SnapshotStore store{connection, folder, 1};
+    const auto snapshot = store.take();
+    ASSERT_TRUE(snapshot);
+    const auto restore =
+        tdu::speed_test([&] { store.restore(*snapshot); });
+    report("SnapshotStore::restore", restore, 1);
+
+    EXPECT_EQ(connection->db().execAndGet("PRAGMA journal_mode").getString(),
+              "wal");
+    EXPECT_EQ(
+        connection->db().execAndGet("SELECT count(*) FROM tasks").getInt(),
+        BENCH_ROWS);
+    fs::remove_all(folder);
+}
+
+TEST_F(BenchmarkTest, MessageSendLatency) {
+    constexpr unsigned int SENDS = 1'000;
+    const tdc::MessageDb message_db{connection};
+    const tdc::Message message{1, "someguy", "Some message.",
+                               tdu::get_current_timestamp()};
+
+    const auto direct = tdu::speed_test([&] {
+        for (unsigned int i = 0; i < SENDS; ++i) {
+            message_db.add_object(message);
+        }
+    });
+
+    tdc::WriteQueue writes{connection};
+    const auto queued = tdu::speed_test([&] {
+        for (unsigned int i = 0; i < SENDS; ++i) {
+            const auto ticket =
+                writes.submit([&] { message_db.add_object(message); });
+        }
+    });
+    const auto durable = tdu::speed_test([&] { writes.flush().wait(); });
+
+    report("MessageDb::add_object (direct)", direct, SENDS);
+    report("MessageDb::add_object (queued)", queued, SENDS);
+    report("WriteQueue::flush (after queued sends)", durable, 1);
+    std::cout << std::format("[ BENCH    ] WriteQueue group commits: {}\n",
+                             writes.stats().commits);
+
+    EXPECT_LT(queued.count(), direct.count());
+}
+
+TEST_F(BenchmarkTest, WipeAllData) {
+    SQL::Database& db = connection->db();
+
+    // Row by row, as every DELETE on a table with triggers is.
+    fill_tasks(db, BENCH_ROWS);
+    const auto deleting = tdu::speed_test([&] {
+        tdc::UnitOfWork work{*connection};
+        db.exec("DELETE FROM tasks");
+        work.commit();
+    });
+
+    fill_tasks(db, BENCH_ROWS);
+    tdc::WipeStats stats{};
+    const auto wiping = tdu::speed_test([&] {
+        stats = tdc::clear_all_db_data(*connection, {"tasks"});
+    });
+
+    report("DELETE FROM tasks", deleting, 1);
+    report("clear_all_db_data (tasks)", wiping, 1);
+    std::cout << std::format("[ BENCH    ] Wipe freed {} of {} bytes\n",
+                             stats.bytes_before - stats.bytes_after,
+                             stats.bytes_before);
+
+    EXPECT_LT(wiping.count(), deleting.count());
+}
+
+TEST_F(BenchmarkTest, TaskListingAfterArchiving) {
+    constexpr unsigned int LISTINGS = 100;
+    SQL::Database& db = connection->db();
+    const fs::path archive_path =
+        fs::temp_directory_path() / "2do_bench_archive.db3";
+    fs::remove(archive_path);
+    std::ofstream{archive_path}.close();
+
+    // Nine tasks in ten are done, as in a long-lived database.
+    fill_tasks(db, BENCH_ROWS);
+    db.exec("UPDATE tasks SET is_done = 1 WHERE task_id % 100 >= 10");
+    tdc::TaskDb task_db{connection};
+
+    const auto list_all = [&] {
+        for (unsigned int i = 0; i < LISTINGS; ++i) {
+            const auto tasks =
+                task_db.get_all_objects<tdc::TaskDb::IdType::Owner>(3);
+        }
+    };
+
+    const auto before = tdu::speed_test(list_all);
+    tdc::ArchiveStats stats{};
+    {
+        tdc::TaskArchive archive{connection, archive_path, sch::days{30}};
+        stats = archive.archive_done(tdu::get_current_timestamp() +
+                                     sch::days{31});
+    }
+    const auto after = tdu::speed_test(list_all);
+
+    report("TaskDb::get_all_objects (all tasks in place)", before, LISTINGS);
+    report("TaskDb::get_all_objects (done tasks archived)", after, LISTINGS);
+    report("TaskArchive::archive_done", stats.elapsed, stats.tasks);
+
+    EXPECT_EQ(stats.tasks, BENCH_ROWS / 10 * 9);
+    EXPECT_LT(after.count(), before.count());
+    fs::remove(archive_path);
+}
+
+TEST_F(BenchmarkTest, PooledReadersUnderConcurrentWrites) {
+    constexpr unsigned int READERS = 3;
+    constexpr sch::milliseconds DURATION{500};
+    connection.reset();
+
+    // No busy timeout, so every time a connection is locked out shows.
+    for (auto profile : {tdc::DURABLE_PROFILE, tdc::BALANCED_PROFILE}) {
+        profile.busy_timeout_ms = 0;
+        remove_db_files();
+        SQL::Database{db_path, SQL::OPEN_READWRITE | SQL::OPEN_CREATE};
+
+        tdc::ConnectionPool pool{db_path, profile, READERS};
+        const tdc::MessageDb writer_db{pool.writer()};
+        const tdc::Message message{1, "someguy", "Hello",
+                                   tdu::get_current_timestamp()};
+        const auto seeded =
+            writer_db.add_objects(Vector<tdc::Message>(1'000, message));
+
+        std::atomic<unsigned int> reads = 0;
+        std::atomic<unsigned int> read_busy = 0;
+        std::atomic<bool> stop = false;
+        // Opened up front, so only reads are timed.
+        Vector<tdc::ReaderLease> leases;
+        Vector<tdc::MessageDb> reader_dbs;
+        for (unsigned int i = 0; i < READERS; ++i) {
+            leases.push_back(pool.acquire_reader());
+            reader_dbs.emplace_back(leases.back().connection());
+        }
+
+        Vector<std::jthread> readers;
+        for (const auto& reader_db : reader_dbs) {
+            readers.emplace_back([&] {
+                while (!stop) {
+                    try {
+                        const auto last = reader_db.get_last_n(1, 50);
+                        ++reads;
+                    } catch (const SQL::Exception& e) {
+                        if (e.getErrorCode() != SQLITE_BUSY) {
+                            throw;
+                        }
+                        ++read_busy;
+                    }
+                    std::this_thread::yield();
+                }
+            });
+        }
+
+        unsigned int writes = 0;
+        unsigned int write_busy = 0;
+        const auto deadline = sch::steady_clock::now() + DURATION;
+        while (sch::steady_clock::now() < deadline) {
+            try {
+                writer_db.add_object(message);
+                ++writes;
+            } catch (const SQL::Exception& e) {
+                if (e.getErrorCode() != SQLITE_BUSY) {
+                    throw;
+                }
+                ++write_busy;
+            }
+            std::this_thread::yield();
+        }
+        stop = true;
+        readers.clear();
+
+        const double seconds = sch::duration<double>(DURATION).count();
+        std::cout << std::format(
+            "[ BENCH    ] {} profile, {} readers: {:.0f} reads/s, "
+            "{:.0f} writes/s, SQLITE_BUSY {} on reads, {} on writes\n",
+            profile.name, READERS, reads / seconds, writes / seconds,
+            read_busy.load(), write_busy);
+
+        EXPECT_EQ(read_busy, 0);
+        EXPECT_EQ(write_busy, 0);
+        EXPECT_GT(reads, 0);
+        EXPECT_GT(writes, 0);
+    }
+}
+
+TEST(TimerWheelBenchmark, ScheduleAndExpireDeadlines) {
+    constexpr unsigned int DEADLINES = 100'000;
+    const int64_t start = tdu::to_epoch_minutes(tdu::get_current_timestamp());
+    // Spread over a year, the way task deadlines are.
+    const auto due_of = [&](const unsigned int id) {
+        return start + 1 + (id * 7'919LL) % (365 * 24 * 60);
+    };
+
+    tdc::TimerWheel wheel{start};
+    const auto scheduling = tdu::speed_test([&] {
+        for (unsigned int id = 0; id < DEADLINES; ++id) {
+            wheel.schedule(id, due_of(id));
+        }
+    });
+
+    std::size_t fired = 0;
+    const auto expiry = tdu::speed_test([&] {
+        for (int64_t now = start; wheel.size() > 0; now += 60) {
+            fired += wheel.advance(now).size();
+        }
+    });
+
+    BenchmarkTest::report("TimerWheel::schedule", scheduling, DEADLINES);
+    BenchmarkTest::report("TimerWheel::advance (hourly over a year)", expiry,
+                          DEADLINES);
+
+    EXPECT_EQ(fired, DEADLINES);
+}
+
+namespace {
+String legacy_to_string(const TimePoint tp) {
+    return std::format("{:%Y-%m-%d %H:%M}", tp);
+}
+
+std::optional<TimePoint> legacy_to_time_point(const String& tp_str) {
+    std::istringstream iss(tp_str);
+    sch::sys_time<sch::minutes> tp;
+    if (!(iss >> std::chrono::parse("%Y-%m-%d %H:%M", tp)).fail())
+        return sch::time_point_cast<sch::minutes>(tp);
+    else
+        return std::nullopt;
+}
+
+template <typename F>
+void bench_per_op(StringView name, const unsigned int ops, F&& op) {
+    const std::size_t allocations_before = alloc_counter::count();
+    const auto elapsed = tdu::speed_test([&] {
+        for (unsigned int i = 0; i < ops; ++i) {
+            op(i);
+        }
+    });
+    const std::size_t allocations = alloc_counter::count() - allocations_before;
+
+    std::cout << std::format(
+        "[ BENCH    ] {}: {:.1f} ns/op, {:.2f} allocs/op\n", name,
+        static_cast<double>(elapsed.count()) / ops,
+        static_cast<double>(allocations) / ops);
+}
+}  // namespace
+
+TEST(DateCodecBenchmark, FastCodecAgainstStreamsAndFormat) {
+    constexpr unsigned int OPS = 100'000;
+    const TimePoint base = tdu::get_current_timestamp();
+    const String text = tdu::to_string(base);
+
+    std::size_t sink = 0;
+    tdu::TimePointChars chars;
+
+    bench_per_op("std::format to_string (legacy)", OPS, [&](unsigned int i) {
+        sink += legacy_to_string(base + sch::minutes{i}).size();
+    });
+    bench_per_op("tdu::format_time_point", OPS, [&](unsigned int i) {
+        sink += tdu::format_time_point(base + sch::minutes{i}, chars).size();
+    });
+    bench_per_op("tdu::to_string", OPS, [&](unsigned int i) {
+        sink += tdu::to_string(base + sch::minutes{i}).size();
+    });
+    bench_per_op("istringstream to_time_point (legacy)", OPS,
+                 [&](unsigned int) {
+                     sink += legacy_to_time_point(text).has_value();
+                 });
+    bench_per_op("tdu::parse_time_point", OPS, [&](unsigned int) {
+        sink += tdu::parse_time_point(text).has_value();
+    });
+
+    EXPECT_EQ(tdu::parse_time_point(text), legacy_to_time_point(text));
+    EXPECT_EQ(tdu::to_string(base), legacy_to_string(base));
+
+    const std::size_t allocations_before = alloc_counter::count();
+    for (unsigned int i = 0; i < OPS; ++i) {
+        sink += tdu::format_time_point(base + sch::minutes{i}, chars).size();
+        sink += tdu::parse_time_point(text).has_value();
+    }
+    EXPECT_EQ(alloc_counter::count(), allocations_before);
+    EXPECT_GT(sink, 0);
+}
@@ -1,11 +1,29 @@
+#include <2DOCore/archive.hpp>
+#include <2DOCore/backup.hpp>
+#include <2DOCore/database.hpp>
+#include <2DOCore/migration.hpp>
+#include <2DOCore/notifier.hpp>
+#include <2DOCore/pool.hpp>
 #include <2DOCore/task.hpp>
+#include <2DOCore/transfer.hpp>
 #include <2DOCore/user.hpp>
+#include <2DOCore/wipe.hpp>
+#include <2DOCore/write_queue.hpp>
 #include <Utils/type.hpp>
 #include <Utils/util.hpp>
 
+#include <SQLiteCpp/Statement.h>
 #include <gtest/gtest.h>
+#include <atomic>
+#include <condition_variable>
+#include <format>
+#include <fstream>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
 
 namespace tdc = twodocore;
 namespace tdu = twodoutils;
@@ -13,12 +31,14 @@ namespace tdu = twodoutils;
 constexpr StringView TEST_DB_PATH = ":memory:";
 
 struct DbTest : testing::Test {
+    std::shared_ptr<tdc::Connection> connection =
+        std::make_shared<tdc::Connection>(TEST_DB_PATH);
     std::unique_ptr<tdc::UserDb> user_db =
-        std::make_unique<tdc::UserDb>(TEST_DB_PATH);
+        std::make_unique<tdc::UserDb>(connection);
     std::unique_ptr<tdc::TaskDb> task_db =
-        std::make_unique<tdc::TaskDb>(TEST_DB_PATH);
+        std::make_unique<tdc::TaskDb>(connection);
     std::unique_ptr<tdc::MessageDb> msg_db =
-        std::make_unique<tdc::MessageDb>(TEST_DB_PATH);
+        std::make_unique<tdc::MessageDb>(connection);
 
     void TearDown() override {
         user_db.reset();
@@ -120,12 +140,909 @@ TEST_F(DbTest, CheckMessageDbFunctionalities) {
 
     const auto new_msg = tdc::Message{1, "someguy", "newest message",
                                       tdu::get_current_timestamp()};
-    EXPECT_NO_THROW(msg_db->add_object(new_msg));
+    unsigned int new_msg_id = 0;
+    EXPECT_NO_THROW(new_msg_id = msg_db->add_object(new_msg));
+    EXPECT_EQ(new_msg_id, messages.back().message_id() + 1);
 
     std::optional<tdc::Message> selected_new_msg;
     EXPECT_NO_THROW(selected_new_msg = msg_db->get_newest_object());
     EXPECT_EQ(selected_new_msg.value().content(), new_msg.content());
+    EXPECT_EQ(selected_new_msg.value().message_id(), new_msg_id);
 
     EXPECT_NO_THROW(msg_db->delete_all_by_task_id(1));
     EXPECT_TRUE(msg_db->is_table_empty());
 }
+
+TEST_F(DbTest, CheckBatchInsertion) {
+    Vector<tdc::Task> tasks;
+    for (unsigned int i = 0; i < 100; ++i) {
+        tasks.push_back(tdc::Task{"Topic", "Content",
+                                  tdu::get_current_timestamp(),
+                                  tdu::get_current_timestamp(1), 1, 2, false});
+    }
+
+    Vector<unsigned int> ids;
+    EXPECT_NO_THROW(ids = task_db->add_objects(tasks));
+    ASSERT_EQ(ids.size(), tasks.size());
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        EXPECT_EQ(tasks[i].id(), ids[i]);
+        EXPECT_EQ(task_db->get_object(ids[i]), tasks[i]);
+    }
+
+    for (auto& task : tasks) {
+        task.set_is_done(true);
+    }
+    EXPECT_NO_THROW(task_db->update_objects(tasks));
+    EXPECT_TRUE(task_db->get_object(ids.back()).is_done());
+
+    const Vector<tdc::User> users = {
+        tdc::User{"first", tdc::Role::User, "Password123!"},
+        tdc::User{"second", tdc::Role::User, "Password123!"}};
+    EXPECT_EQ(user_db->add_objects(users).size(), users.size());
+    EXPECT_EQ(user_db->get_all_objects().size(), users.size());
+
+    const Array<tdc::Message, 2> messages = {
+        tdc::Message{1, "first", "Hi!", tdu::get_current_timestamp()},
+        tdc::Message{1, "second", "Hello!", tdu::get_current_timestamp()}};
+    const auto message_ids = msg_db->add_objects(messages);
+    EXPECT_EQ(message_ids.back(), message_ids.front() + 1);
+    EXPECT_EQ(msg_db->get_all_objects(1).size(), messages.size());
+}
+
+TEST_F(DbTest, CheckIncrementalMessageFetch) {
+    EXPECT_FALSE(msg_db->get_newest_id(1));
+
+    Vector<tdc::Message> messages;
+    for (unsigned int i = 0; i < 10; ++i) {
+        messages.push_back(tdc::Message{i % 2 + 1, "someguy",
+                                        std::to_string(i),
+                                        tdu::get_current_timestamp()});
+    }
+    const auto ids = msg_db->add_objects(messages);
+
+    EXPECT_EQ(msg_db->get_newest_id(1), ids[8]);
+    EXPECT_EQ(msg_db->get_newest_id(2), ids[9]);
+
+    const auto tail = msg_db->get_last_n(1, 3);
+    ASSERT_EQ(tail.size(), 3);
+    EXPECT_EQ(tail[0].content(), "4");
+    EXPECT_EQ(tail[2].content(), "8");
+
+    const auto since = msg_db->get_messages_since(1, ids[4]);
+    ASSERT_EQ(since.size(), 2);
+    EXPECT_EQ(since[0].message_id(), ids[6]);
+    EXPECT_EQ(since[1].message_id(), ids[8]);
+
+    EXPECT_EQ(msg_db->get_messages_since(1, 0, 2).size(), 2);
+    EXPECT_TRUE(msg_db->get_messages_since(1, ids[8]).empty());
+}
+
+TEST_F(DbTest, CheckFullTextSearch) {
+    tdc::Task report{"Quarterly report",
+                     "Collect the sales figures",
+                     tdu::get_current_timestamp(),
+                     tdu::get_current_timestamp(1),
+                     1,
+                     2,
+                     false};
+    tdc::Task party{"Office party",
+                    "Order pizza",
+                    tdu::get_current_timestamp(),
+                    tdu::get_current_timestamp(1),
+                    1,
+                    2,
+                    false};
+    task_db->add_object(report);
+    task_db->add_object(party);
+    msg_db->add_object(tdc::Message{party.id(), "someguy", "Bring the report",
+                                    tdu::get_current_timestamp()});
+
+    // A topic match outranks a match in the discussion.
+    auto hits = task_db->search("report", 1, 10);
+    ASSERT_EQ(hits.size(), 2);
+    EXPECT_EQ(hits[0].task_id, report.id());
+    EXPECT_EQ(hits[0].snippet, "Quarterly [report]");
+    EXPECT_EQ(hits[1].task_id, party.id());
+    EXPECT_EQ(hits[1].topic, "Office party");
+
+    EXPECT_EQ(task_db->search("sales fig", 1, 10).size(), 1);
+    EXPECT_EQ(task_db->search("report", 1, 1).size(), 1);
+    EXPECT_TRUE(task_db->search("\"report OR", 1, 10).empty());
+    EXPECT_TRUE(task_db->search("   ", 1, 10).empty());
+
+    // Triggers keep the index in step with edits and deletes.
+    party.set_content("Order sushi");
+    task_db->update_object(party);
+    EXPECT_TRUE(task_db->search("pizza", 1, 10).empty());
+    EXPECT_EQ(task_db->search("sushi", 1, 10).size(), 1);
+
+    msg_db->delete_all_by_task_id(party.id());
+    task_db->delete_object(report.id());
+    EXPECT_TRUE(task_db->search("report", 1, 10).empty());
+
+    // Better matches in other users' tasks do not crowd out the user's own.
+    tdc::Task theirs{"Report report report",
+                     "Report",
+                     tdu::get_current_timestamp(),
+                     tdu::get_current_timestamp(1),
+                     3,
+                     4,
+                     false};
+    task_db->add_objects(Vector<tdc::Task>(50, theirs));
+    hits = task_db->search("report", 1, 10);
+    EXPECT_TRUE(hits.empty());
+    task_db->add_object(tdc::Task{"Annual report", "Plain content",
+                                  tdu::get_current_timestamp(),
+                                  tdu::get_current_timestamp(1), 1, 2, false});
+    hits = task_db->search("report", 1, 10);
+    ASSERT_EQ(hits.size(), 1);
+    EXPECT_EQ(hits[0].topic, "Annual report");
+    EXPECT_EQ(task_db->search("report", 3, 10).size(), 10);
+}
+
+TEST_F(DbTest, CheckWorkloadStats) {
+    tdc::User worker{"worker", tdc::Role::User, "Pass123!"};
+    tdc::User idle{"idle", tdc::Role::User, "Pass123!"};
+    user_db->add_object(worker);
+    user_db->add_object(idle);
+
+    const TimePoint now = tdu::get_current_timestamp();
+    const auto add_task = [&](const TimePoint deadline, const bool done) {
+        task_db->add_object(tdc::Task{"Topic", "Content", now - sch::days{30},
+                                      deadline, worker.id(), idle.id(), done});
+    };
+    add_task(now - sch::days{1}, false);  // overdue
+    add_task(now + sch::days{2}, false);  // due soon
+    add_task(now + sch::days{20}, false);
+    add_task(now - sch::days{1}, true);   // done, not overdue
+
+    const auto stats = task_db->workload_stats(now, sch::days{7});
+    ASSERT_EQ(stats.size(), 2);
+
+    EXPECT_EQ(stats[0].username, "worker");
+    EXPECT_EQ(stats[0].open, 3);
+    EXPECT_EQ(stats[0].done, 1);
+    EXPECT_EQ(stats[0].overdue, 1);
+    EXPECT_EQ(stats[0].due_soon, 1);
+
+    EXPECT_EQ(stats[1].user_id, idle.id());
+    EXPECT_EQ(stats[1].open + stats[1].done, 0);
+}
+
+TEST(SchemaTest, GeneratesStatementsFromFields) {
+    EXPECT_STREQ((tdc::select_sql<tdc::User, " WHERE user_id = ?">()),
+                 "SELECT user_id, username, role, password FROM users "
+                 "WHERE user_id = ?");
+    EXPECT_STREQ(tdc::insert_sql<tdc::Message>(),
+                 "INSERT INTO messages (task_id, sender_name, content, "
+                 "timestamp) VALUES (?, ?, ?, ?)");
+    EXPECT_STREQ(tdc::update_sql<tdc::Task>(),
+                 "UPDATE tasks SET topic = ?, content = ?, start_date = ?, "
+                 "deadline = ?, executor_id = ?, owner_id = ?, is_done = ? "
+                 "WHERE task_id = ?");
+    EXPECT_STREQ(tdc::select_sql<tdc::TaskSummary>(),
+                 "SELECT task_id, topic, deadline, owner_id, is_done "
+                 "FROM tasks");
+}
+
+TEST_F(DbTest, CheckCursorPagination) {
+    Vector<tdc::Task> tasks;
+    for (unsigned int i = 0; i < 25; ++i) {
+        tasks.push_back(tdc::Task{"Topic", "Content",
+                                  tdu::get_current_timestamp(),
+                                  tdu::get_current_timestamp(1), 1, i % 2,
+                                  false});
+    }
+    const auto ids = task_db->add_objects(tasks);
+
+    static_assert(std::ranges::input_range<tdc::Cursor<tdc::Task>>);
+
+    Vector<tdc::Task> streamed;
+    for (const auto& task :
+         task_db->stream_all_objects<tdc::TaskDb::IdType::Executor>(1)) {
+        streamed.push_back(task);
+    }
+    EXPECT_EQ(streamed, tasks);
+
+    unsigned int after_id = 0;
+    Vector<std::size_t> page_sizes;
+    while (true) {
+        std::size_t page_size = 0;
+        for (const auto& task :
+             task_db->stream_all_objects<tdc::TaskDb::IdType::Executor>(
+                 1, after_id, 10)) {
+            EXPECT_GT(task.id(), after_id);
+            after_id = task.id();
+            ++page_size;
+        }
+        if (page_size == 0) {
+            break;
+        }
+        page_sizes.push_back(page_size);
+    }
+    EXPECT_EQ(page_sizes, (Vector<std::size_t>{10, 10, 5}));
+    EXPECT_EQ(after_id, ids.back());
+
+    auto owned = task_db->stream_all_objects<tdc::TaskDb::IdType::Owner>(1);
+    EXPECT_EQ(std::ranges::distance(owned), 12);
+
+    const Vector<tdc::User> users = {
+        tdc::User{"first", tdc::Role::User, "Password123!"},
+        tdc::User{"second", tdc::Role::User, "Password123!"},
+        tdc::User{"third", tdc::Role::User, "Password123!"}};
+    const auto user_ids = user_db->add_objects(users);
+    auto page = user_db->stream_all_objects(user_ids.front(), 1);
+    auto it = page.begin();
+    ASSERT_NE(it, page.end());
+    EXPECT_EQ(it->username(), users[1].username());
+    EXPECT_EQ(++it, page.end());
+}
+
+TEST_F(DbTest, CheckTaskSummaries) {
+    const tdc::Task task{"Topic",
+                         String(1'000, 'x'),
+                         tdu::get_current_timestamp(),
+                         tdu::get_current_timestamp(1),
+                         1,
+                         2,
+                         true};
+    const auto ids = task_db->add_objects(Vector<tdc::Task>(3, task));
+
+    Vector<tdc::TaskSummary> summaries;
+    for (auto&& summary :
+         task_db->stream_all_summaries<tdc::TaskDb::IdType::Owner>(2)) {
+        summaries.push_back(std::move(summary));
+    }
+
+    ASSERT_EQ(summaries.size(), ids.size());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        EXPECT_EQ(summaries[i],
+                  (tdc::TaskSummary{ids[i], String{task.topic()},
+                                    task.deadline<TimePoint>(),
+                                    task.owner_id(), task.is_done()}));
+    }
+
+    auto page = task_db->stream_all_summaries<tdc::TaskDb::IdType::Executor>(
+        1, ids.front(), 1);
+    EXPECT_EQ(page.begin()->id(), ids[1]);
+}
+
+TEST(MigrationTest, UpgradesLegacyDatabaseInPlace) {
+    SQL::Database db{TEST_DB_PATH, SQL::OPEN_READWRITE};
+    db.exec(
+        "CREATE TABLE tasks (task_id INTEGER PRIMARY KEY AUTOINCREMENT NOT "
+        "NULL, topic VARCHAR(20) NOT NULL, content TEXT NOT NULL, start_date "
+        "VARCHAR(10) NOT NULL, deadline VARCHAR(10) NOT NULL, executor_id "
+        "INTEGER NOT NULL, owner_id INTEGER NOT NULL, is_done BOOLEAN NOT "
+        "NULL)");
+    db.exec(
+        "INSERT INTO tasks (topic, content, start_date, deadline, executor_id, "
+        "owner_id, is_done) VALUES ('Topic', 'Content', '2024-01-01 10:00', "
+        "'2024-01-02 10:00', 1, 2, 0)");
+    EXPECT_EQ(tdc::schema_version(db), 0);
+
+    EXPECT_NO_THROW(tdc::migrate(db));
+    EXPECT_EQ(tdc::schema_version(db), tdc::migrations().back().version);
+    EXPECT_TRUE(db.tableExists("users"));
+    EXPECT_TRUE(db.tableExists("messages"));
+
+    for (const auto index :
+         {"tasks_executor_id_idx", "tasks_owner_id_idx",
+          "messages_task_id_message_id_idx", "users_username_idx"}) {
+        SQL::Statement query{
+            db, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' "
+                "AND name = ?"};
+        query.bind(1, index);
+        query.executeStep();
+        EXPECT_EQ(query.getColumn(0).getInt(), 1) << index;
+    }
+
+    SQL::Statement dates{db, "SELECT start_date, deadline FROM tasks"};
+    ASSERT_TRUE(dates.executeStep());
+    EXPECT_EQ(
+        dates.getColumn(0).getInt64(),
+        tdu::to_epoch_minutes(tdu::to_time_point("2024-01-01 10:00").value()));
+    EXPECT_EQ(
+        dates.getColumn(1).getInt64(),
+        tdu::to_epoch_minutes(tdu::to_time_point("2024-01-02 10:00").value()));
+    EXPECT_FALSE(dates.executeStep());
+
+    EXPECT_NO_THROW(tdc::migrate(db));
+    EXPECT_EQ(tdc::schema_version(db), tdc::migrations().back().version);
+}
+
+TEST_F(DbTest, CheckUnitOfWork) {
+    const tdc::Task task{"Topic",
+                         "Content",
+                         tdu::get_current_timestamp(),
+                         tdu::get_current_timestamp(1),
+                         1,
+                         2,
+                         false};
+
+    unsigned int task_id = 0;
+    {
+        tdc::UnitOfWork work{*connection};
+        task_id = task_db->add_object(task);
+        msg_db->add_object(tdc::Message{task_id, "someguy", "Hello!",
+                                        tdu::get_current_timestamp()});
+    }
+    EXPECT_TRUE(task_db->is_table_empty());
+    EXPECT_TRUE(msg_db->is_table_empty());
+
+    {
+        tdc::UnitOfWork work{*connection};
+        task_id = task_db->add_object(task);
+        msg_db->add_object(tdc::Message{task_id, "someguy", "Hello!",
+                                        tdu::get_current_timestamp()});
+        work.commit();
+    }
+    EXPECT_FALSE(task_db->is_table_empty());
+    EXPECT_FALSE(msg_db->is_table_empty());
+
+    {
+        tdc::UnitOfWork work{*connection};
+        task_db->delete_object(task_id);
+        msg_db->delete_all_by_task_id(task_id);
+        work.commit();
+    }
+    EXPECT_TRUE(task_db->is_table_empty());
+    EXPECT_TRUE(msg_db->is_table_empty());
+}
+
+TEST(ConnectionTest, AppliesConnectionProfile) {
+    const fs::path db_path = fs::temp_directory_path() / "2do_profile.db3";
+    fs::remove(db_path);
+    SQL::Database{db_path, SQL::OPEN_READWRITE | SQL::OPEN_CREATE};
+
+    const auto profile = tdc::find_connection_profile("fast");
+    ASSERT_TRUE(profile);
+    EXPECT_FALSE(tdc::find_connection_profile("unknown"));
+
+    {
+        tdc::Connection connection{db_path, profile.value()};
+
+        SQL::Statement journal_mode{connection.db(), "PRAGMA journal_mode"};
+        journal_mode.executeStep();
+        EXPECT_EQ(journal_mode.getColumn(0).getString(), "wal");
+
+        SQL::Statement synchronous{connection.db(), "PRAGMA synchronous"};
+        synchronous.executeStep();
+        EXPECT_EQ(synchronous.getColumn(0).getInt(), 0);
+    }
+
+    fs::remove(db_path);
+    fs::remove(fs::path{db_path} += "-wal");
+    fs::remove(fs::path{db_path} += "-shm");
+}
+
+TEST_F(DbTest, CheckIdentityMapCache) {
+    tdc::Task task{"Topic",
+                   "Content",
+                   tdu::get_current_timestamp(),
+                   tdu::get_current_timestamp(1),
+                   1,
+                   2,
+                   false};
+    task_db->add_object(task);
+
+    EXPECT_EQ(task_db->get_object(task.id()), task);
+    EXPECT_EQ(task_db->get_object(task.id()), task);
+    EXPECT_EQ(task_db->cache_stats().hits, 1);
+    EXPECT_EQ(task_db->cache_stats().misses, 1);
+
+    task.set_topic("Written through");
+    task_db->update_object(task);
+    EXPECT_EQ(task_db->get_object(task.id()), task);
+    EXPECT_EQ(task_db->cache_stats().hits, 2);
+
+    // A change behind the repository's back is seen through the update hook.
+    connection->db().exec("UPDATE tasks SET topic = 'Hooked'");
+    EXPECT_EQ(task_db->get_object(task.id()).topic(), "Hooked");
+
+    {
+        tdc::UnitOfWork work{*connection};
+        task.set_topic("Rolled back");
+        task_db->update_object(task);
+    }
+    EXPECT_EQ(task_db->get_object(task.id()).topic(), "Hooked");
+
+    tdc::User user{"patryk", tdc::Role::Admin, "Patryk123!"};
+    user_db->add_object(user);
+    EXPECT_EQ(user_db->get_all_objects().size(), 1);
+    EXPECT_EQ(user_db->get_all_objects().size(), 1);
+    EXPECT_EQ(user_db->cache_stats().hits, 1);
+
+    user_db->add_object(tdc::User{"someguy", tdc::Role::User, "Pass123!"});
+    EXPECT_EQ(user_db->get_all_objects().size(), 2);
+
+    const auto wiped = tdc::clear_all_db_data(*connection, {"users", "tasks"});
+    EXPECT_LE(wiped.bytes_after, wiped.bytes_before);
+    EXPECT_TRUE(user_db->get_all_objects().empty());
+    EXPECT_ANY_THROW(task_db->get_object(task.id()));
+}
+
+TEST_F(DbTest, CheckMessageChangeNotifications) {
+    const std::uint64_t seen = msg_db->change_version();
+
+    // The insert wakes the waiter right away, well inside the poll interval.
+    std::jthread sender{[&] {
+        tdu::sleep(20);
+        msg_db->add_object(
+            tdc::Message{1, "someguy", "Hello!", tdu::get_current_timestamp()});
+    }};
+    const auto elapsed = tdu::speed_test([&] {
+        EXPECT_NE(msg_db->wait_for_change(seen, std::stop_token{}), seen);
+    });
+    EXPECT_LT(elapsed, sch::milliseconds{500});
+
+    // With nothing to report, a stop request is what ends the wait.
+    std::jthread waiter{[&](std::stop_token stop) {
+        const std::uint64_t current = msg_db->change_version();
+        EXPECT_EQ(msg_db->wait_for_change(current, stop), current);
+    }};
+    tdu::sleep(20);
+    waiter.request_stop();
+}
+
+TEST(ChangeNotifierTest, SeesCommitsFromOtherConnections) {
+    const fs::path db_path = fs::temp_directory_path() / "2do_notifier.db3";
+    fs::remove(db_path);
+    SQL::Database{db_path, SQL::OPEN_READWRITE | SQL::OPEN_CREATE};
+
+    {
+        tdc::Connection reader{db_path};
+        tdc::ChangeNotifier notifier{reader, "messages",
+                                     sch::milliseconds{10}};
+
+        const std::uint64_t seen = notifier.version();
+        tdc::MessageDb{std::make_shared<tdc::Connection>(db_path)}.add_object(
+            tdc::Message{1, "someguy", "Hello!", tdu::get_current_timestamp()});
+        EXPECT_NE(notifier.wait(seen, std::stop_token{}), seen);
+    }
+
+    fs::remove(db_path);
+}
+
+TEST(TransferTest, RoundTripsEveryFormat) {
+    const Array<String, 4> contents = {
+        "Plain", "Comma, \"quotes\" and\nnew lines", "Tab\tand \\ slash",
+        "Unicode \u017c\u00f3\u0142w \U0001F600"};
+
+    for (const StringView extension : {".csv", ".jsonl"}) {
+        const fs::path path =
+            fs::temp_directory_path() / ("2do_transfer" + String{extension});
+        const auto format = tdc::transfer_format_of(path);
+        ASSERT_TRUE(format);
+
+        const auto source = std::make_shared<tdc::Connection>(TEST_DB_PATH);
+        tdc::MessageDb source_db{source};
+        for (const auto& content : contents) {
+            source_db.add_object(tdc::Message{
+                7, "someguy", content, tdu::get_current_timestamp()});
+        }
+        const auto exported =
+            tdc::export_table(*source, "messages", *format, path);
+        EXPECT_EQ(exported.rows, contents.size());
+
+        const auto target = std::make_shared<tdc::Connection>(TEST_DB_PATH);
+        const auto imported =
+            tdc::import_table(*target, "messages", *format, path, 3);
+        EXPECT_EQ(imported.rows, contents.size());
+        EXPECT_EQ(tdc::MessageDb{target}.get_all_objects(7),
+                  source_db.get_all_objects(7));
+
+        fs::remove(path);
+    }
+
+    EXPECT_FALSE(tdc::transfer_format_of("data.txt"));
+    EXPECT_THROW(
+        {
+            const auto stats = tdc::export_table(
+                *std::make_shared<tdc::Connection>(TEST_DB_PATH),
+                "sqlite_master", tdc::TransferFormat::Csv, "unused.csv");
+            EXPECT_EQ(stats.rows, 0);
+        },
+        std::runtime_error);
+}
+
+TEST(TransferTest, KeepsNullApartFromEmptyText) {
+    const TimePoint now = tdu::get_current_timestamp();
+    const auto source = std::make_shared<tdc::Connection>(TEST_DB_PATH);
+    tdc::TaskDb source_db{source};
+    source_db.add_object(tdc::Task{"Open", "", now, now, 1, 2, false});
+    source_db.add_object(tdc::Task{"Done", "Content", now, now, 1, 2, true});
+
+    const auto count = [](tdc::Connection& connection, const char* where) {
+        return connection.db()
+            .execAndGet(String{"SELECT count(*) FROM tasks WHERE "} + where)
+            .getInt();
+    };
+
+    for (const StringView extension : {".csv", ".jsonl"}) {
+        const fs::path path =
+            fs::temp_directory_path() / ("2do_nulls" + String{extension});
+        const auto format = tdc::transfer_format_of(path);
+        ASSERT_TRUE(format);
+
+        const auto exported =
+            tdc::export_table(*source, "tasks", *format, path);
+        EXPECT_EQ(exported.rows, 2);
+
+        const auto target = std::make_shared<tdc::Connection>(TEST_DB_PATH);
+        const auto imported =
+            tdc::import_table(*target, "tasks", *format, path);
+        EXPECT_EQ(imported.rows, 2);
+        EXPECT_EQ(count(*target, "done_at IS NULL AND content = ''"), 1);
+        EXPECT_EQ(count(*target, "done_at IS NOT NULL"), 1);
+        EXPECT_EQ(count(*target, "typeof(done_at) = 'text'"), 0);
+
+        fs::remove(path);
+    }
+}
+
+TEST(TransferTest, RejectsMalformedInput) {
+    const fs::path path = fs::temp_directory_path() / "2do_malformed.jsonl";
+    const auto connection = std::make_shared<tdc::Connection>(TEST_DB_PATH);
+
+    for (const StringView text :
+         {"{\"message_id\": 1, \"content\": \"unterminated}\n",
+          "{\"no_such_column\": 1}\n",
+          "{\"task_id\": 1}\n{\"content\": \"other keys\"}\n"}) {
+        {
+            std::ofstream{path} << text;
+        }
+        EXPECT_THROW(
+            {
+                const auto stats = tdc::import_table(
+                    *connection, "messages", tdc::TransferFormat::Jsonl, path);
+                EXPECT_EQ(stats.rows, 0);
+            },
+            std::runtime_error)
+            << text;
+    }
+    EXPECT_TRUE(tdc::MessageDb{connection}.is_table_empty());
+
+    fs::remove(path);
+}
+
+TEST_F(DbTest, CheckSnapshotsAndRestore) {
+    const fs::path folder = fs::temp_directory_path() / "2do_snapshots";
+    fs::remove_all(folder);
+    fs::create_directories(folder);
+
+    tdc::Task task{"Topic", "Before the snapshot", tdu::get_current_timestamp(),
+                   tdu::get_current_timestamp(1), 1, 2, false};
+    task_db->add_object(task);
+
+    tdc::SnapshotStore store{connection, folder, 2};
+    const auto snapshot = store.take();
+    ASSERT_TRUE(snapshot);
+    EXPECT_EQ(fs::directory_iterator{folder}->path(), snapshot->path);
+
+    task.set_content("After the snapshot");
+    task_db->update_object(task);
+    const auto other = task_db->add_object(std::as_const(task));
+
+    std::size_t resets = 0;
+    const auto subscription = connection->subscribe(
+        [&](const tdc::Change change, StringView, int64_t) {
+            resets += change == tdc::Change::Reset;
+        });
+    store.restore(*snapshot);
+    EXPECT_EQ(resets, 1);
+    EXPECT_EQ(task_db->get_object(task.id()).content(), "Before the snapshot");
+    EXPECT_THROW(const auto gone = task_db->get_object(other),
+                 std::runtime_error);
+
+    // Only the newest two are kept, and set_keep prunes at once.
+    ASSERT_TRUE(store.take());
+    const auto newest = store.take();
+    ASSERT_TRUE(newest);
+    EXPECT_EQ(store.list().size(), 2);
+    EXPECT_EQ(store.list().front().path, newest->path);
+    store.set_keep(1);
+    EXPECT_EQ(store.list().size(), 1);
+
+    // A stopped snapshot leaves no partial file behind.
+    std::stop_source stopped;
+    stopped.request_stop();
+    const auto unfinished = store.take(stopped.get_token());
+    EXPECT_EQ(std::distance(fs::directory_iterator{folder},
+                            fs::directory_iterator{}),
+              1);
+
+    fs::remove_all(folder);
+}
+
+TEST_F(DbTest, CheckFastWipe) {
+    user_db->add_object(tdc::User{"patryk", tdc::Role::Admin, "Patryk123!"});
+    tdc::Task task{"Wipeable topic", "Content", tdu::get_current_timestamp(),
+                   tdu::get_current_timestamp(1), 1, 1, false};
+    Vector<tdc::Task> tasks(500, task);
+    const auto ids = task_db->add_objects(tasks);
+    msg_db->add_object(tdc::Message{ids.front(), "patryk", "Wipeable message",
+                                    tdu::get_current_timestamp()});
+
+    Vector<tdc::WipeProgress> progress;
+    const auto stats = tdc::clear_all_db_data(
+        *connection, {"users", "tasks", "messages"},
+        [&](const tdc::WipeProgress& step) { progress.push_back(step); });
+
+    ASSERT_EQ(progress.size(), 5);
+    for (std::size_t i = 0; i < progress.size(); ++i) {
+        EXPECT_EQ(progress[i].done, i);
+        EXPECT_EQ(progress[i].total, 4);
+    }
+    EXPECT_LT(stats.bytes_after, stats.bytes_before);
+
+    EXPECT_TRUE(user_db->is_table_empty());
+    EXPECT_TRUE(task_db->is_table_empty());
+    EXPECT_TRUE(msg_db->is_table_empty());
+    EXPECT_TRUE(task_db->search("wipeable", 1, 10).empty());
+
+    // Indexes, triggers and a fresh AUTOINCREMENT come back with the tables.
+    EXPECT_EQ(task_db->add_object(task), 1);
+    EXPECT_EQ(task_db->search("wipeable", 1, 10).size(), 1);
+    EXPECT_TRUE(connection->db().execAndGet(
+        "SELECT count(*) FROM sqlite_master "
+        "WHERE name = 'tasks_workload_idx'").getInt());
+
+    EXPECT_THROW(
+        {
+            const auto unknown =
+                tdc::clear_all_db_data(*connection, {"no_such_table"});
+            EXPECT_EQ(unknown.bytes_after, unknown.bytes_before);
+        },
+        std::runtime_error);
+}
+
+TEST_F(DbTest, CheckArchiveDoneTasks) {
+    const fs::path path = fs::temp_directory_path() / "2do_archive.db3";
+    fs::remove(path);
+    std::ofstream{path}.close();
+
+    const TimePoint now = tdu::get_current_timestamp();
+    tdc::Task task{"Archivable topic", "Content", now, now, 1, 2, false};
+    const auto open = task_db->add_object(std::as_const(task));
+    task.set_is_done(true);
+    const auto done = task_db->add_object(std::as_const(task));
+    const auto reopened = task_db->add_object(std::as_const(task));
+    msg_db->add_object(tdc::Message{done, "someguy", "Archivable", now});
+    msg_db->add_object(tdc::Message{open, "someguy", "Still open", now});
+
+    task.set_id(reopened);
+    task.set_is_done(false);
+    task_db->update_object(task);
+
+    tdc::TaskArchive archive{connection, path, sch::days{30}};
+    EXPECT_EQ(archive.archive_done(now).tasks, 0);
+
+    const auto stats = archive.archive_done(now + sch::days{31});
+    EXPECT_EQ(stats.tasks, 1);
+    EXPECT_EQ(stats.messages, 1);
+    EXPECT_EQ(archive.task_count(), 1);
+
+    const auto hot = task_db->get_all_objects<tdc::TaskDb::IdType::Owner>(2);
+    ASSERT_EQ(hot.size(), 2);
+    EXPECT_EQ(hot[0].id(), open);
+    EXPECT_EQ(hot[1].id(), reopened);
+    EXPECT_THROW(const auto gone = task_db->get_object(done),
+                 std::runtime_error);
+    EXPECT_TRUE(msg_db->get_all_objects(done).empty());
+    EXPECT_EQ(msg_db->get_all_objects(open).size(), 1);
+    EXPECT_EQ(task_db->search("archivable", 1, 10).size(), 2);
+
+    Vector<tdc::Task> archived;
+    for (auto&& row : archive.stream_tasks(1)) {
+        archived.push_back(std::move(row));
+    }
+    ASSERT_EQ(archived.size(), 1);
+    EXPECT_EQ(archived[0].id(), done);
+    EXPECT_TRUE(archived[0].is_done());
+    ASSERT_EQ(archive.get_messages(done).size(), 1);
+    EXPECT_EQ(archive.get_messages(done)[0].content(), "Archivable");
+
+    // Running again moves nothing twice.
+    EXPECT_EQ(archive.archive_done(now + sch::days{31}).tasks, 0);
+    EXPECT_EQ(archive.task_count(), 1);
+
+    // A restore rolling the id counter back does not hand out an archived
+    // id again.
+    task.set_is_done(true);
+    const auto late = task_db->add_object(std::as_const(task));
+    EXPECT_EQ(archive.archive_done(now + sch::days{31}).tasks, 1);
+    connection->db().exec(std::format(
+        "UPDATE sqlite_sequence SET seq = {} WHERE name = 'tasks'", late - 1));
+    archive.reserve_archived_ids();
+    EXPECT_GT(task_db->add_object(std::as_const(task)), late);
+    EXPECT_EQ(archive.task_count(), 2);
+
+    archive.clear();
+    EXPECT_EQ(archive.task_count(), 0);
+
+    fs::remove(path);
+}
+
+TEST(ConnectionPoolTest, ReadersReadSnapshotsWhileTheWriterCommits) {
+    const fs::path path = fs::temp_directory_path() / "2do_pool.db3";
+    fs::remove(path);
+    std::ofstream{path}.close();
+
+    tdc::ConnectionPool pool{path, tdc::BALANCED_PROFILE, 2};
+    const tdc::TaskDb writer_db{pool.writer()};
+    const tdc::Task task{"Topic", "Content", tdu::get_current_timestamp(),
+                         tdu::get_current_timestamp(1), 1, 2, false};
+    writer_db.add_object(task);
+
+    {
+        const auto lease = pool.acquire_reader();
+        EXPECT_EQ(lease.connection()->role(), tdc::ConnectionRole::Reader);
+        const tdc::TaskDb reader_db{lease.connection()};
+        EXPECT_THROW(reader_db.add_object(task), SQL::Exception);
+
+        // An open read keeps its snapshot, and does not hold up the commit.
+        SQL::Database& db = lease.connection()->db();
+        db.exec("BEGIN");
+        EXPECT_EQ(reader_db.get_all_objects<tdc::TaskDb::IdType::Owner>(2)
+                      .size(),
+                  1);
+        writer_db.add_object(task);
+        EXPECT_EQ(reader_db.get_all_objects<tdc::TaskDb::IdType::Owner>(2)
+                      .size(),
+                  1);
+        db.exec("COMMIT");
+        EXPECT_EQ(reader_db.get_all_objects<tdc::TaskDb::IdType::Owner>(2)
+                      .size(),
+                  2);
+
+        EXPECT_EQ(pool.stats().open_readers, 1);
+        EXPECT_EQ(pool.stats().leased_readers, 1);
+    }
+    EXPECT_EQ(pool.stats().leased_readers, 0);
+
+    // Idle readers are reused, and past the limit a lease waits for one.
+    auto first = std::make_optional(pool.acquire_reader());
+    const auto second = pool.acquire_reader();
+    EXPECT_EQ(pool.stats().open_readers, 2);
+
+    std::atomic<bool> leased = false;
+    std::jthread waiter{[&] {
+        const auto third = pool.acquire_reader();
+        leased = true;
+    }};
+    std::this_thread::sleep_for(sch::milliseconds{50});
+    EXPECT_FALSE(leased);
+    first.reset();
+    waiter.join();
+    EXPECT_TRUE(leased);
+    EXPECT_EQ(pool.stats().open_readers, 2);
+
+    fs::remove(path);
+    fs::remove(fs::path{path} += "-wal");
+    fs::remove(fs::path{path} += "-shm");
+}
+
+TEST(ConnectionPoolTest, ReadersHearOfTheWritersCommits) {
+    const fs::path path = fs::temp_directory_path() / "2do_pool_follow.db3";
+    fs::remove(path);
+    std::ofstream{path}.close();
+
+    tdc::ConnectionPool pool{path};
+    const auto lease = pool.acquire_reader();
+    {
+        tdc::WriteQueue writes{pool.writer()};
+        const tdc::TaskDb writer_db{pool.writer()};
+        const tdc::MessageDb writer_messages{pool.writer()};
+        const tdc::TaskDb reader_db{lease.connection()};
+
+        tdc::Task task{"Topic", "Before", tdu::get_current_timestamp(),
+                       tdu::get_current_timestamp(1), 1, 2, false};
+        writer_db.add_object(task);
+        EXPECT_EQ(reader_db.get_object(task.id()).content(), "Before");
+
+        // The reader's cache hears of the commit, and the read waits for
+        // this thread's queued write to commit first.
+        task.set_content("After");
+        const auto ticket =
+            writes.submit([&, task] { writer_db.update_object(task); });
+        EXPECT_EQ(reader_db.get_object(task.id()).content(), "After");
+
+        // Far too long a poll for the wait to end by polling.
+        tdc::ChangeNotifier notifier{*lease.connection(), "messages",
+                                     sch::hours{1}};
+        const std::uint64_t seen = notifier.version();
+        std::jthread sender{[&] {
+            std::this_thread::sleep_for(sch::milliseconds{20});
+            const auto sent = writes.submit([&] {
+                writer_messages.add_object(
+                    tdc::Message{task.id(), "someguy", "Hello",
+                                 tdu::get_current_timestamp()});
+            });
+        }};
+        std::stop_source stop;
+        std::jthread watchdog{[&](std::stop_token done) {
+            std::mutex mutex;
+            std::condition_variable_any timeout;
+            std::unique_lock<std::mutex> lock{mutex};
+            if (!timeout.wait_for(lock, done, sch::seconds{10},
+                                  [] { return false; }) &&
+                !done.stop_requested()) {
+                stop.request_stop();
+            }
+        }};
+        EXPECT_NE(notifier.wait(seen, stop.get_token()), seen);
+        EXPECT_EQ(tdc::MessageDb{lease.connection()}.get_newest_id(task.id()),
+                  1);
+    }
+
+    fs::remove(path);
+    fs::remove(fs::path{path} += "-wal");
+    fs::remove(fs::path{path} += "-shm");
+}
+
+TEST(ConnectionPoolTest, SnapshotsAndArchiveReadThroughReaders) {
+    const fs::path path = fs::temp_directory_path() / "2do_pool_jobs.db3";
+    const fs::path archive_path =
+        fs::temp_directory_path() / "2do_pool_archive.db3";
+    const fs::path folder = fs::temp_directory_path() / "2do_pool_snapshots";
+    for (const auto& file : {path, archive_path}) {
+        fs::remove(file);
+        std::ofstream{file}.close();
+    }
+    fs::remove_all(folder);
+    fs::create_directories(folder);
+
+    const auto pool = std::make_shared<tdc::ConnectionPool>(path);
+    const auto lease = pool->acquire_reader();
+    {
+        const tdc::TaskDb writer_db{pool->writer()};
+        const tdc::TaskDb reader_db{lease.connection()};
+        const TimePoint now = tdu::get_current_timestamp();
+        tdc::Task task{"Topic", "Before", now, now, 1, 2, false};
+        writer_db.add_object(task);
+
+        // A write left open on the writer stays out of the snapshot.
+        tdc::SnapshotStore store{pool, folder, 2};
+        std::optional<tdc::Snapshot> snapshot;
+        {
+            tdc::UnitOfWork work{*pool->writer()};
+            task.set_content("Uncommitted");
+            writer_db.update_object(task);
+            snapshot = store.take();
+        }
+        ASSERT_TRUE(snapshot);
+        EXPECT_EQ(pool->stats().open_readers, 2);
+        EXPECT_EQ(pool->stats().leased_readers, 1);
+        EXPECT_EQ(SQL::Database{snapshot->path}
+                      .execAndGet("SELECT content FROM tasks")
+                      .getString(),
+                  "Before");
+
+        // A restore through the writer resets the readers' caches.
+        task.set_content("After");
+        writer_db.update_object(task);
+        EXPECT_EQ(reader_db.get_object(task.id()).content(), "After");
+        store.restore(*snapshot);
+        EXPECT_EQ(reader_db.get_object(task.id()).content(), "Before");
+
+        // Archived rows are read back through the reader.
+        tdc::TaskArchive archive{pool->writer(), archive_path,
+                                 sch::days{30}, lease.connection()};
+        task.set_is_done(true);
+        writer_db.update_object(task);
+        EXPECT_EQ(archive.archive_done(now + sch::days{31}).tasks, 1);
+        EXPECT_EQ(archive.task_count(), 1);
+        auto archived = archive.stream_tasks(1);
+        EXPECT_EQ(archived.begin()->id(), task.id());
+        EXPECT_THROW(const auto gone = reader_db.get_object(task.id()),
+                     std::runtime_error);
+    }
+
+    fs::remove_all(folder);
+    for (const auto& file : {path, archive_path}) {
+        fs::remove(file);
+        fs::remove(fs::path{file} += "-wal");
+        fs::remove(fs::path{file} += "-shm");
+    }
+}
@@ -0,0 +1,124 @@
+#include <cstdint>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include <2DOCore/database.hpp>
+#include <2DOCore/scheduler.hpp>
+#include <2DOCore/task.hpp>
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace tdc = twodocore;
+namespace tdu = twodoutils;
+
+TEST(TimerWheelTest, FiresEveryTimerOnItsTick) {
+    // Around today in epoch minutes, with dues spread over every level and
+    // past the top one.
+    const int64_t start = 29'000'000;
+    tdc::TimerWheel wheel{start};
+
+    HashMap<unsigned int, int64_t> dues;
+    uint64_t seed = 42;
+    for (unsigned int id = 0; id < 10'000; ++id) {
+        seed = seed * 6'364'136'223'846'793'005ULL + 1;
+        const int64_t due = start + 1 + (seed >> 33) % (1 << 25);
+        dues.insert({id, due});
+        wheel.schedule(id, due);
+    }
+    EXPECT_EQ(wheel.size(), dues.size());
+
+    int64_t now = start;
+    std::size_t fired = 0;
+    while (wheel.size() > 0) {
+        const int64_t previous = now;
+        now += 1 + (now % 7) * 997;
+
+        for (const auto& timer : wheel.advance(now)) {
+            EXPECT_EQ(timer.due, dues.at(timer.id));
+            EXPECT_GT(timer.due, previous);
+            EXPECT_LE(timer.due, now);
+            ++fired;
+        }
+    }
+    EXPECT_EQ(fired, dues.size());
+}
+
+TEST(TimerWheelTest, CancelsAndReschedules) {
+    tdc::TimerWheel wheel{1'000};
+
+    wheel.schedule(1, 1'010);
+    wheel.schedule(2, 1'010);
+    wheel.schedule(3, 900);
+    EXPECT_TRUE(wheel.cancel(2));
+    EXPECT_FALSE(wheel.cancel(2));
+    wheel.schedule(1, 5'000);
+
+    // A due time already past fires on the next advance.
+    auto fired = wheel.advance(1'000);
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].id, 3);
+
+    EXPECT_TRUE(wheel.advance(4'999).empty());
+    fired = wheel.advance(5'000);
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].id, 1);
+    EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(DeadlineSchedulerTest, RemindsBeforeAndAtDeadline) {
+    const auto connection = std::make_shared<tdc::Connection>(":memory:");
+    const tdc::TaskDb task_db{connection};
+
+    const TimePoint now = tdu::get_current_timestamp();
+    const auto make_task = [&](const TimePoint deadline) {
+        return tdc::Task{"Topic", "Content", now, deadline, 1, 2, false};
+    };
+
+    tdc::Task soon = make_task(now + sch::minutes{30});
+    tdc::Task later = make_task(now + sch::days{3});
+    tdc::Task past = make_task(now - sch::minutes{5});
+    task_db.add_object(soon);
+    task_db.add_object(later);
+    task_db.add_object(past);
+
+    tdc::DeadlineScheduler scheduler{connection, sch::hours{1}, now};
+
+    // Already inside the lead time, so reminded at once; the past deadline
+    // is left alone.
+    auto reminders = scheduler.poll(now);
+    ASSERT_EQ(reminders.size(), 1);
+    EXPECT_EQ(reminders[0].kind, tdc::Reminder::Kind::DueSoon);
+    EXPECT_EQ(reminders[0].task_id, soon.id());
+    EXPECT_EQ(reminders[0].executor_id, 1);
+    EXPECT_EQ(scheduler.pending(), 2);
+
+    // Other edits do not repeat a reminder already given.
+    soon.set_topic("Renamed");
+    task_db.update_object(soon);
+    EXPECT_TRUE(scheduler.poll(now + sch::minutes{1}).empty());
+
+    reminders = scheduler.poll(now + sch::minutes{30});
+    ASSERT_EQ(reminders.size(), 1);
+    EXPECT_EQ(reminders[0].kind, tdc::Reminder::Kind::Overdue);
+    EXPECT_EQ(reminders[0].topic, "Renamed");
+    EXPECT_EQ(scheduler.pending(), 1);
+
+    // Moving the deadline reschedules; finishing the task drops it.
+    later.set_deadline(now + sch::hours{2});
+    task_db.update_object(later);
+    reminders = scheduler.poll(now + sch::hours{1});
+    ASSERT_EQ(reminders.size(), 1);
+    EXPECT_EQ(reminders[0].task_id, later.id());
+
+    later.set_is_done(true);
+    task_db.update_object(later);
+    EXPECT_TRUE(scheduler.poll(now + sch::days{4}).empty());
+    EXPECT_EQ(scheduler.pending(), 0);
+
+    // New tasks are picked up as they are added.
+    tdc::Task added = make_task(now + sch::days{5});
+    task_db.add_object(added);
+    EXPECT_TRUE(scheduler.poll(now + sch::days{4}).empty());
+    EXPECT_EQ(scheduler.pending(), 1);
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace tdu = twodoutils;
+
+TEST(DateCodecTest, FormatsFixedWidth) {
+    tdu::TimePointChars chars;
+
+    EXPECT_EQ(tdu::format_time_point(tdu::from_epoch_minutes(0), chars),
+              "1970-01-01 00:00");
+    EXPECT_EQ(tdu::format_time_point(
+                  tdu::to_time_point("2024-02-29 23:59").value(), chars),
+              "2024-02-29 23:59");
+    EXPECT_EQ(tdu::format_time_point(
+                  tdu::to_time_point("0001-01-01 00:00").value(), chars),
+              "0001-01-01 00:00");
+    EXPECT_EQ(tdu::to_string(tdu::from_epoch_minutes(-1)), "1969-12-31 23:59");
+}
+
+TEST(DateCodecTest, RoundTripsEveryDayOfFourCenturies) {
+    tdu::TimePointChars chars;
+    const int64_t first = tdu::to_epoch_minutes(
+        tdu::parse_time_point("1900-01-01 00:00").value());
+
+    for (int64_t day = 0; day < 146097; ++day) {
+        const auto tp = tdu::from_epoch_minutes(first + day * 1440 + 754);
+        const auto formatted = tdu::format_time_point(tp, chars);
+        ASSERT_EQ(tdu::parse_time_point(formatted), tp) << formatted;
+    }
+}
+
+TEST(DateCodecTest, RejectsInvalidInput) {
+    EXPECT_FALSE(tdu::parse_time_point(""));
+    EXPECT_FALSE(tdu::parse_time_point("2024-01-01"));
+    EXPECT_FALSE(tdu::parse_time_point("2024-13-01 10:00"));
+    EXPECT_FALSE(tdu::parse_time_point("2023-02-29 10:00"));
+    EXPECT_FALSE(tdu::parse_time_point("2024-01-01 24:00"));
+    EXPECT_FALSE(tdu::parse_time_point("2024-01-01 10:60"));
+    EXPECT_FALSE(tdu::parse_time_point("2024/01/01 10:00"));
+    EXPECT_FALSE(tdu::parse_time_point("2024-01-01 10:00 tomorrow"));
+
+    EXPECT_EQ(tdu::parse_time_point("2024-1-5 9:05"),
+              tdu::parse_time_point("2024-01-05 09:05"));
+}
@@ -0,0 +1,207 @@
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <2DOCore/database.hpp>
+#include <2DOCore/task.hpp>
+#include <2DOCore/write_queue.hpp>
+#include <Utils/type.hpp>
+#include <Utils/util.hpp>
+
+namespace tdc = twodocore;
+namespace tdu = twodoutils;
+
+TEST(BoundedQueueTest, KeepsOrderAndRejectsWhenFull) {
+    tdc::BoundedQueue<int> queue{4};
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(queue.try_push(int{i}), i);
+    }
+    EXPECT_FALSE(queue.try_push(4));
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(queue.try_pop(), i);
+    }
+    EXPECT_FALSE(queue.try_pop());
+    EXPECT_EQ(queue.try_push(5), 4);
+}
+
+TEST(BoundedQueueTest, DeliversEveryValueOnceAcrossProducers) {
+    constexpr int PRODUCERS = 4;
+    constexpr int PER_PRODUCER = 10'000;
+    tdc::BoundedQueue<int> queue{64};
+
+    Vector<std::jthread> producers;
+    for (int producer = 0; producer < PRODUCERS; ++producer) {
+        producers.emplace_back([&, producer] {
+            for (int i = 0; i < PER_PRODUCER; ++i) {
+                while (!queue.try_push(producer * PER_PRODUCER + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Each producer's values must come out in the order it pushed them.
+    Vector<int> last(PRODUCERS, -1);
+    for (int received = 0; received < PRODUCERS * PER_PRODUCER;) {
+        if (const auto value = queue.try_pop()) {
+            const int producer = *value / PER_PRODUCER;
+            EXPECT_GT(*value, last[producer]);
+            last[producer] = *value;
+            ++received;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    for (int producer = 0; producer < PRODUCERS; ++producer) {
+        EXPECT_EQ(last[producer], (producer + 1) * PER_PRODUCER - 1);
+    }
+    EXPECT_FALSE(queue.try_pop());
+}
+
+struct WriteQueueTest : testing::Test {
+    std::shared_ptr<tdc::Connection> connection =
+        std::make_shared<tdc::Connection>(":memory:");
+    tdc::TaskDb task_db{connection};
+    tdc::MessageDb msg_db{connection};
+
+    tdc::Task task{"Topic", "Content", tdu::get_current_timestamp(),
+                   tdu::get_current_timestamp(1), 1, 2, false};
+};
+
+TEST_F(WriteQueueTest, GroupsWritesIntoFewCommits) {
+    constexpr unsigned int MESSAGES = 2'000;
+    tdc::WriteQueue writes{connection};
+
+    for (unsigned int i = 0; i < MESSAGES; ++i) {
+        const auto ticket = writes.submit([&] {
+            msg_db.add_object(tdc::Message{7, "someguy", "Hello",
+                                           tdu::get_current_timestamp()});
+        });
+    }
+    writes.flush().wait();
+
+    EXPECT_EQ(msg_db.get_all_objects(7).size(), MESSAGES);
+    EXPECT_EQ(writes.stats().writes, MESSAGES + 1);
+    EXPECT_LT(writes.stats().commits, MESSAGES);
+}
+
+TEST_F(WriteQueueTest, ReadsSeeTheirOwnThreadsWrites) {
+    task_db.add_object(task);
+    tdc::WriteQueue writes{connection};
+
+    for (unsigned int i = 0; i < 100; ++i) {
+        task.set_content("Edit " + std::to_string(i));
+        const auto ticket = writes.submit(
+            [this, edited = task] { task_db.update_object(edited); });
+
+        EXPECT_EQ(task_db.get_object(task.id()).content(), task.content());
+    }
+}
+
+TEST_F(WriteQueueTest, RollsBackOnlyTheFailingWrite) {
+    std::atomic<unsigned int> errors = 0;
+    tdc::WriteQueue writes{connection,
+                           [&](std::exception_ptr) { ++errors; }};
+
+    const auto first = writes.submit([&] { task_db.add_object(task); });
+    const auto failing = writes.submit([&] {
+        task_db.add_object(task);
+        throw std::runtime_error("Rejected.");
+    });
+    const auto last = writes.submit([&] { task_db.add_object(task); });
+
+    EXPECT_NO_THROW(first.wait());
+    EXPECT_THROW(failing.wait(), std::runtime_error);
+    EXPECT_NO_THROW(last.wait());
+    EXPECT_EQ(errors, 1);
+    EXPECT_EQ(task_db.get_all_objects<tdc::TaskDb::IdType::Owner>(2).size(),
+              2);
+}
+
+TEST_F(WriteQueueTest, SubmitWaitsForRoomWhileFull) {
+    std::promise<void> release;
+    const std::shared_future<void> released = release.get_future().share();
+    tdc::WriteQueue writes{connection, {}, 2};
+
+    // The writer holds the first write while two more fill the queue.
+    std::atomic<bool> started = false;
+    const auto held = writes.submit([&] {
+        started = true;
+        started.notify_one();
+        released.wait();
+    });
+    started.wait(false);
+    const auto second = writes.submit([] {});
+    const auto third = writes.submit([] {});
+
+    std::atomic<bool> submitted = false;
+    std::jthread producer{[&] {
+        const auto ticket = writes.submit([] {});
+        submitted = true;
+    }};
+    std::this_thread::sleep_for(sch::milliseconds{50});
+    EXPECT_FALSE(submitted);
+
+    release.set_value();
+    producer.join();
+    EXPECT_TRUE(submitted);
+    writes.flush().wait();
+    EXPECT_EQ(writes.stats().writes, 5);
+}
+
+TEST_F(WriteQueueTest, OtherThreadsWaitForTheOpenGroup) {
+    std::promise<void> release;
+    const std::shared_future<void> released = release.get_future().share();
+    tdc::WriteQueue writes{connection};
+
+    std::atomic<bool> started = false;
+    const auto held = writes.submit([&] {
+        task_db.add_object(task);
+        started = true;
+        started.notify_one();
+        released.wait();
+    });
+    started.wait(false);
+
+    // Queued by another thread, so only the connection's lock holds the
+    // read back until the group commits.
+    std::atomic<bool> read = false;
+    std::jthread reader{[&] {
+        tdc::UnitOfWork work{*connection};
+        EXPECT_FALSE(task_db.is_table_empty());
+        work.commit();
+        read = true;
+    }};
+    std::this_thread::sleep_for(sch::milliseconds{50});
+    EXPECT_FALSE(read);
+
+    release.set_value();
+    reader.join();
+    EXPECT_TRUE(read);
+    EXPECT_NO_THROW(held.wait());
+}
+
+TEST_F(WriteQueueTest, DrainsOnDestructionAndOwnsTheConnection) {
+    {
+        tdc::WriteQueue writes{connection};
+        EXPECT_THROW(tdc::WriteQueue{connection}, std::runtime_error);
+
+        for (unsigned int i = 0; i < 100; ++i) {
+            const auto ticket = writes.submit([&] {
+                msg_db.add_object(tdc::Message{7, "someguy", "Hello",
+                                               tdu::get_current_timestamp()});
+            });
+        }
+    }
+
+    EXPECT_EQ(msg_db.get_all_objects(7).size(), 100);
+    EXPECT_NO_THROW(tdc::WriteQueue{connection});
+}
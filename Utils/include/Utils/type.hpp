@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <memory_resource>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -10,6 +11,9 @@ using StringView = std::string_view;
 
 template <typename T>
 using Vector = std::vector<T>;
+using PmrString = std::pmr::string;
+template <typename T>
+using PmrVector = std::pmr::vector<T>;
 template <typename T, size_t S>
 using Array = std::array<T, S>;
 template <typename K, typename V>
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <filesystem>
 #include <optional>
@@ -34,10 +36,33 @@ fs::path create_app_env(const String& folder_name, const Vector<String>& files);
 [[nodiscard]] TimePoint get_current_timestamp(
     const unsigned int additional_days = 0);
 
+inline constexpr std::size_t TIME_POINT_STR_LEN = 16;
+
+using TimePointChars = Array<char, TIME_POINT_STR_LEN>;
+
+// Writes "YYYY-MM-DD hh:mm" into out and returns a view of it. Does not
+// allocate; years outside 0000-9999 yield an empty view.
+[[nodiscard]] StringView format_time_point(const TimePoint tp,
+                                           TimePointChars& out) noexcept;
+
+// Parses "YYYY-MM-DD hh:mm" without allocating. Like std::chrono::parse the
+// fields may be shorter than their full width and the date and time may be
+// separated by any amount of whitespace.
+[[nodiscard]] std::optional<TimePoint> parse_time_point(
+    StringView str) noexcept;
+
 [[nodiscard]] String to_string(const TimePoint tp);
 
 [[nodiscard]] std::optional<TimePoint> to_time_point(const String& tp_str);
 
+[[nodiscard]] constexpr int64_t to_epoch_minutes(const TimePoint tp) {
+    return tp.time_since_epoch().count();
+}
+
+[[nodiscard]] constexpr TimePoint from_epoch_minutes(const int64_t minutes) {
+    return TimePoint{sch::minutes{minutes}};
+}
+
 inline void clear_term() {
 #ifdef _WIN32
     ::system("cls");
@@ -1,5 +1,6 @@
 #include "Utils/util.hpp"
 
+#include <cctype>
 #include <chrono>
 #include <format>
 #include <fstream>
@@ -7,6 +8,61 @@
 namespace fs = std::filesystem;
 
 namespace twodoutils {
+namespace {
+constexpr int64_t MINUTES_PER_DAY = 24 * 60;
+
+struct CivilDate {
+    int64_t year;
+    unsigned month;
+    unsigned day;
+};
+
+constexpr int64_t floor_div(const int64_t a, const int64_t b) {
+    return (a >= 0 ? a : a - b + 1) / b;
+}
+
+// Howard Hinnant's days_from_civil / civil_from_days over the proleptic
+// Gregorian calendar, days counted from 1970-01-01.
+constexpr int64_t days_from_civil(int64_t year,
+                                  const unsigned month,
+                                  const unsigned day) {
+    year -= month <= 2;
+    const int64_t era = floor_div(year, 400);
+    const auto yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 +
+                         day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+constexpr CivilDate civil_from_days(int64_t days) {
+    days += 719468;
+    const int64_t era = floor_div(days, 146097);
+    const auto doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe =
+        (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    return {static_cast<int64_t>(yoe) + era * 400 + (month <= 2), month, day};
+}
+
+static_assert(days_from_civil(1970, 1, 1) == 0);
+static_assert(civil_from_days(19'723).year == 2024);
+
+constexpr int days_in_month(const int year, const int month) {
+    constexpr int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    const bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    return (month == 2 && leap) ? 29 : days[month - 1];
+}
+
+inline void write_digits(char* out, const unsigned value) {
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+}
+}  // namespace
+
 NanoSeconds speed_test(const std::function<void()>& test) {
     auto start = std::chrono::high_resolution_clock::now();
 
@@ -87,16 +143,99 @@ TimePoint get_current_timestamp(const unsigned int additional_days) {
     return future_time;
 }
 
+StringView format_time_point(const TimePoint tp,
+                             TimePointChars& out) noexcept {
+    const int64_t minutes = to_epoch_minutes(tp);
+    const int64_t days = floor_div(minutes, MINUTES_PER_DAY);
+    const auto minute_of_day =
+        static_cast<unsigned>(minutes - days * MINUTES_PER_DAY);
+    const CivilDate date = civil_from_days(days);
+
+    if (date.year < 0 || date.year > 9999) {
+        return {};
+    }
+
+    const auto year = static_cast<unsigned>(date.year);
+    write_digits(&out[0], year / 100);
+    write_digits(&out[2], year % 100);
+    out[4] = '-';
+    write_digits(&out[5], date.month);
+    out[7] = '-';
+    write_digits(&out[8], date.day);
+    out[10] = ' ';
+    write_digits(&out[11], minute_of_day / 60);
+    out[13] = ':';
+    write_digits(&out[14], minute_of_day % 60);
+
+    return {out.data(), out.size()};
+}
+
+std::optional<TimePoint> parse_time_point(StringView str) noexcept {
+    std::size_t pos = 0;
+    const auto field = [&](const std::size_t max_width) -> std::optional<int> {
+        int value = 0;
+        std::size_t width = 0;
+        while (pos < str.size() && width < max_width && str[pos] >= '0' &&
+               str[pos] <= '9') {
+            value = value * 10 + (str[pos++] - '0');
+            ++width;
+        }
+        return width ? std::optional<int>{value} : std::nullopt;
+    };
+    const auto literal = [&](const char c) {
+        if (pos < str.size() && str[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    };
+    const auto whitespace = [&] {
+        while (pos < str.size() && std::isspace((unsigned char)str[pos])) {
+            ++pos;
+        }
+    };
+
+    const auto year = field(4);
+    if (!year || !literal('-')) {
+        return std::nullopt;
+    }
+    const auto month = field(2);
+    if (!month || !literal('-')) {
+        return std::nullopt;
+    }
+    const auto day = field(2);
+    whitespace();
+    const auto hour = field(2);
+    if (!day || !hour || !literal(':')) {
+        return std::nullopt;
+    }
+    const auto minute = field(2);
+    whitespace();
+    if (!minute || pos != str.size()) {
+        return std::nullopt;
+    }
+
+    if (*month < 1 || *month > 12 || *day < 1 ||
+        *day > days_in_month(*year, *month) || *hour > 23 || *minute > 59) {
+        return std::nullopt;
+    }
+
+    return from_epoch_minutes(
+        days_from_civil(*year, *month, *day) * MINUTES_PER_DAY + *hour * 60 +
+        *minute);
+}
+
 String to_string(const TimePoint tp) {
+    TimePointChars chars;
+    if (const auto formatted = format_time_point(tp, chars);
+        !formatted.empty()) {
+        return String{formatted};
+    }
+
     return std::format("{:%Y-%m-%d %H:%M}", tp);
 }
 
 std::optional<TimePoint> to_time_point(const String& tp_str) {
-    std::istringstream iss(tp_str);
-    sch::sys_time<sch::minutes> tp;
-    if (!(iss >> std::chrono::parse("%Y-%m-%d %H:%M", tp)).fail())
-        return sch::time_point_cast<sch::minutes>(tp);
-    else
-        return std::nullopt;
+    return parse_time_point(tp_str);
 }
 }  // namespace twodoutils
\ No newline at end of file